@@ -0,0 +1,101 @@
+#pragma once
+
+// Allocation counting hook: replaces the global operator new/delete with versions that count allocations (and bytes) per thread.
+// Per thread, so counting costs a thread_local increment and nothing shared, and it also means you count on the thread doing the work:
+//
+//	alloccount::Scope scope;
+//	... work ...
+//	cout << scope.allocations();	// heap allocations made by this thread since scope was created
+//
+// The operators must be defined in exactly one translation unit: #define ALLOC_COUNT_IMPLEMENTATION before including this header there.
+
+#include <cstddef>
+
+namespace alloccount {
+
+inline thread_local size_t allocations = 0;
+inline thread_local size_t bytes = 0;
+
+class Scope {
+public:
+	size_t allocations() const { return alloccount::allocations - startAllocations; }
+	size_t bytes() const { return alloccount::bytes - startBytes; }
+
+private:
+	size_t startAllocations = alloccount::allocations;
+	size_t startBytes = alloccount::bytes;
+};
+
+} // namespace alloccount
+
+#if defined(ALLOC_COUNT_IMPLEMENTATION)
+
+#include <cstdlib>
+#include <new>
+
+namespace alloccount {
+
+inline void *allocate(std::size_t n, std::size_t align = 0)
+{
+	allocations++;
+	bytes += n;
+	if (n == 0)
+		n = 1;
+#if defined(_MSC_VER)
+	void *p = align ? _aligned_malloc(n, align) : std::malloc(n);
+#else
+	void *p = align ? std::aligned_alloc(align, (n + align - 1) / align * align) : std::malloc(n); // aligned_alloc wants a multiple of align
+#endif
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+inline void release(void *p, std::size_t align = 0) noexcept
+{
+#if defined(_MSC_VER)
+	if (align)
+		return _aligned_free(p);
+#endif
+	(void)align;
+	std::free(p);
+}
+
+} // namespace alloccount
+
+void *operator new(std::size_t n) { return alloccount::allocate(n); }
+void *operator new[](std::size_t n) { return alloccount::allocate(n); }
+void *operator new(std::size_t n, std::align_val_t a) { return alloccount::allocate(n, static_cast<std::size_t>(a)); }
+void *operator new[](std::size_t n, std::align_val_t a) { return alloccount::allocate(n, static_cast<std::size_t>(a)); }
+// The nothrow forms too (get_temporary_buffer, used by stable_sort, allocates with them): otherwise they come from the library's operator new
+// but are freed by the delete above, and they wouldn't be counted
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept
+{
+	try { return alloccount::allocate(n); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept
+{
+	try { return alloccount::allocate(n); } catch (...) { return nullptr; }
+}
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+	try { return alloccount::allocate(n, static_cast<std::size_t>(a)); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+	try { return alloccount::allocate(n, static_cast<std::size_t>(a)); } catch (...) { return nullptr; }
+}
+void operator delete(void *p) noexcept { alloccount::release(p); }
+void operator delete[](void *p) noexcept { alloccount::release(p); }
+void operator delete(void *p, std::size_t) noexcept { alloccount::release(p); }
+void operator delete[](void *p, std::size_t) noexcept { alloccount::release(p); }
+void operator delete(void *p, std::align_val_t a) noexcept { alloccount::release(p, static_cast<std::size_t>(a)); }
+void operator delete[](void *p, std::align_val_t a) noexcept { alloccount::release(p, static_cast<std::size_t>(a)); }
+void operator delete(void *p, std::size_t, std::align_val_t a) noexcept { alloccount::release(p, static_cast<std::size_t>(a)); }
+void operator delete[](void *p, std::size_t, std::align_val_t a) noexcept { alloccount::release(p, static_cast<std::size_t>(a)); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { alloccount::release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { alloccount::release(p); }
+void operator delete(void *p, std::align_val_t a, const std::nothrow_t &) noexcept { alloccount::release(p, static_cast<std::size_t>(a)); }
+void operator delete[](void *p, std::align_val_t a, const std::nothrow_t &) noexcept { alloccount::release(p, static_cast<std::size_t>(a)); }
+
+#endif // ALLOC_COUNT_IMPLEMENTATION
@@ -0,0 +1,140 @@
+#pragma once
+
+// Concurrent append buffers, the lock-free alternatives to threadFunc's  scoped_lock + sT = sT + c  (which copies the whole string,
+// under the lock, for every char: quadratic, and every thread waits for every other).
+//
+// AppendBuffer<T>			one preallocated array, each append reserves its slot with an atomic fetch_add (wait-free), several values at once
+//							with a compare-exchange that only reserves them if they all fit (lock-free). The result is in reservation order,
+//							i.e. it keeps the interleaving between threads. Fixed capacity.
+// SegmentedAppender<T>		one segment per writer thread, appends touch only the thread's own segment (no shared cache lines at all),
+//							merged when the writers are done. Optionally tags every append with a global sequence number so the merge
+//							can restore the interleaving (costs one shared atomic increment per append, same as AppendBuffer).
+//
+// Reading (begin/end, merge) is only valid once the writers are done, e.g. after join(), which is what makes their writes visible.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+template <typename T>
+class AppendBuffer {
+public:
+	explicit AppendBuffer(size_t capacity) : data(new T[capacity]), cap(capacity) {}
+
+	// false when the buffer is full (nothing is written then)
+	bool append(const T &value)
+	{
+		size_t i = tail.fetch_add(1, std::memory_order_relaxed);
+		if (i >= cap)
+			return false;
+		data[i] = value;
+		return true;
+	}
+
+	// n contiguous slots, so the values of one call are never interleaved with other threads. false when they don't all fit (nothing is
+	// written then, and nothing is reserved: a fetch_add would leave tail past slots nobody writes, and size() would count them)
+	bool append(const T *values, size_t n)
+	{
+		size_t i = tail.load(std::memory_order_relaxed);
+		do {
+			if (i > cap || n > cap - i)
+				return false;
+		} while (!tail.compare_exchange_weak(i, i + n, std::memory_order_relaxed));
+		std::copy(values, values + n, data.get() + i);
+		return true;
+	}
+
+	size_t size() const { return std::min(tail.load(std::memory_order_relaxed), cap); }
+	size_t capacity() const { return cap; }
+	const T *begin() const { return data.get(); }
+	const T *end() const { return data.get() + size(); }
+
+	// Not thread safe, only between rounds of writers
+	void clear() { tail.store(0, std::memory_order_relaxed); }
+
+private:
+	std::unique_ptr<T[]> data;
+	size_t cap;
+	alignas(64) std::atomic<size_t> tail { 0 }; // own cache line, it's the one every writer hits
+};
+
+template <typename T>
+class SegmentedAppender {
+	struct alignas(64) Segment {	// padded so neighbouring writers don't false-share
+		std::vector<T> values;
+		std::vector<uint64_t> seqs;	// only in ordered mode
+	};
+
+public:
+	// writers = number of threads that will append, each uses its own index
+	explicit SegmentedAppender(size_t writers, bool ordered = false, size_t reservePerWriter = 0) : segments(writers), ordered(ordered)
+	{
+		for (auto &s : segments) {
+			s.values.reserve(reservePerWriter);
+			if (ordered)
+				s.seqs.reserve(reservePerWriter);
+		}
+	}
+
+	// Handle for one writer thread. Appends never touch anything shared (except the sequence counter in ordered mode)
+	class Writer {
+	public:
+		void append(const T &value)
+		{
+			if (owner->ordered)
+				seg->seqs.push_back(owner->seq.fetch_add(1, std::memory_order_relaxed));
+			seg->values.push_back(value);
+		}
+
+	private:
+		friend class SegmentedAppender;
+		Writer(SegmentedAppender *owner, Segment *seg) : owner(owner), seg(seg) {}
+		SegmentedAppender *owner;
+		Segment *seg;
+	};
+
+	Writer writer(size_t index) { return Writer(this, &segments.at(index)); }
+
+	size_t size() const
+	{
+		size_t n = 0;
+		for (auto &s : segments)
+			n += s.values.size();
+		return n;
+	}
+
+	// Unordered: segment after segment. Ordered: every value goes to the position of its sequence number, so the result is in the
+	// order the appends happened (sequence numbers are unique and dense, so this is a scatter, no sorting needed)
+	template <typename Container>
+	void mergeInto(Container &out) const
+	{
+		if (!ordered) {
+			for (auto &s : segments)
+				out.insert(out.end(), s.values.begin(), s.values.end());
+			return;
+		}
+		size_t base = out.size();
+		out.resize(base + size());
+		for (auto &s : segments)
+			for (size_t i = 0; i < s.values.size(); i++)
+				out[base + s.seqs[i]] = s.values[i];
+	}
+
+	// Not thread safe, only between rounds of writers
+	void clear()
+	{
+		for (auto &s : segments) {
+			s.values.clear();
+			s.seqs.clear();
+		}
+		seq = 0;
+	}
+
+private:
+	std::vector<Segment> segments;
+	bool ordered;
+	alignas(64) std::atomic<uint64_t> seq { 0 };
+};
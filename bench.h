@@ -0,0 +1,322 @@
+#pragma once
+
+// Small statistical micro-benchmark harness, replaces the old one-shot timerFunc lambda in main().
+// Each case gets some warm-up runs (not recorded) and then N timed runs, and we report min/median/p99/mean.
+// Min is usually the most stable number to compare between compilers/flags, p99 shows the noise.
+//
+// Usage:
+//	bench::Suite suite;
+//	suite.add("fill", [&]() { std::fill(p, p + size, 0x77); bench::clobberMemory(); });
+//	suite.run();
+//	suite.writeCsv(file);
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>	// _ReadWriteBarrier
+#endif
+
+#include "perfcounters.h"
+
+namespace bench {
+
+// Compiler barriers, so the optimizer can't throw away the body we want to time (same idea as DoNotOptimize/ClobberMemory in Google Benchmark).
+// doNotOptimize: pretend the value is read by someone we can't see. clobberMemory: pretend all memory may have been read/written.
+template <typename T>
+inline void doNotOptimize(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void *sink;
+	sink = &value;
+	_ReadWriteBarrier();
+#endif
+}
+
+inline void clobberMemory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : : "memory");
+#else
+	_ReadWriteBarrier();
+#endif
+}
+
+struct Options {
+	int warmup = 2;	// runs done before measuring (fills caches, faults in pages, spins up cpu clock)
+	int runs = 15;	// timed runs
+	size_t bytes = 0;	// bytes touched per run, if set we also report bandwidth (GB/s, from the min time)
+};
+
+struct Result {
+	std::string name;
+	int runs = 0;
+	double minUs = 0, medianUs = 0, p99Us = 0, meanUs = 0; // all in MICRO seconds
+	double gbPerSec = 0; // 0 when the case didn't set Options::bytes
+	CounterValues counters; // per run (average over the timed runs), only filled in when the suite runs with counters
+	size_t bytes = 0;
+};
+
+// Nearest-rank percentile of already sorted samples, p in [0,100]
+inline double percentile(const std::vector<double> &sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+	auto rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+	return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// Times body() opts.runs times. setup()/teardown() (if any) are called before/after every run, outside of the timed region.
+// With counters, the hardware counters are also read around every timed run (started before the clock, stopped after it).
+inline Result measure(const std::string &name, const std::function<void()> &body, Options opts = {}, const std::function<void()> &setup = nullptr,
+	const std::function<void()> &teardown = nullptr, PerfCounters *counters = nullptr)
+{
+	using clock = std::chrono::steady_clock; // high_resolution_clock is allowed to jump (it's system_clock on some libs), steady_clock isn't
+
+	for (int i = 0; i < opts.warmup; i++) {
+		if (setup)
+			setup();
+		body();
+		if (teardown)
+			teardown();
+	}
+
+	std::vector<double> samples;
+	samples.reserve(std::max(opts.runs, 1));
+	CounterValues totals { 0, 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < std::max(opts.runs, 1); i++) {
+		if (setup)
+			setup();
+		if (counters)
+			counters->start();
+		clobberMemory();
+		auto start = clock::now();
+		body();
+		clobberMemory();
+		auto stop = clock::now();
+		if (counters) {
+			counters->stop();
+			auto c = counters->read();
+			for (auto field : counterFields)
+				totals.*field = (totals.*field < 0 || c.*field < 0) ? -1 : totals.*field + c.*field;
+		}
+		samples.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+		if (teardown)
+			teardown();
+	}
+
+	std::sort(samples.begin(), samples.end());
+	Result r;
+	r.name = name;
+	r.runs = static_cast<int>(samples.size());
+	r.minUs = samples.front();
+	r.medianUs = percentile(samples, 50);
+	r.p99Us = percentile(samples, 99);
+	double total = 0;
+	for (auto s : samples)
+		total += s;
+	r.meanUs = total / samples.size();
+	if (opts.bytes && r.minUs > 0)
+		r.gbPerSec = opts.bytes / (r.minUs * 1000.0); // bytes per us / 1000 = GB/s
+	if (counters) {
+		r.counters = totals;
+		for (auto field : counterFields)
+			if (r.counters.*field > 0)
+				r.counters.*field /= r.runs;
+		r.bytes = opts.bytes;
+	}
+	return r;
+}
+
+// Keeps calling load() on another thread between start() and stop(). For measuring how a case behaves while something else
+// is hammering the memory system (use start/stop as the setup/teardown of a case).
+class BackgroundLoad {
+public:
+	explicit BackgroundLoad(std::function<void()> load) : load(std::move(load)) {}
+	~BackgroundLoad() { stop(); }
+
+	void start()
+	{
+		stop();
+		stopFlag = false;
+		running = false;
+		worker = std::thread([this]() {
+			running = true;
+			while (!stopFlag.load(std::memory_order_relaxed))
+				load();
+		});
+		while (!running) // don't start timing before the load actually runs
+			std::this_thread::yield();
+	}
+
+	void stop()
+	{
+		stopFlag = true;
+		if (worker.joinable())
+			worker.join();
+	}
+
+private:
+	std::function<void()> load;
+	std::thread worker;
+	std::atomic<bool> stopFlag { false }, running { false };
+};
+
+// A named set of cases, run in the order they were added
+class Suite {
+public:
+	explicit Suite(Options defaults = {}) : defaults(defaults) {}
+
+	Suite &add(std::string name, std::function<void()> body) { return add(std::move(name), std::move(body), defaults); }
+	Suite &add(std::string name, std::function<void()> body, Options opts, std::function<void()> setup = nullptr, std::function<void()> teardown = nullptr)
+	{
+		cases.push_back({ std::move(name), std::move(body), opts, std::move(setup), std::move(teardown) });
+		return *this;
+	}
+
+	// Only run cases whose name contains filter (empty = run everything)
+	void setFilter(std::string f) { filter = std::move(f); }
+	// Override the number of timed runs for every case (0 = use each case's own Options)
+	void setRuns(int n) { forcedRuns = n; }
+	// Also record hardware counters (perfcounters.h) and show IPC, bytes/cycle, misses, TLB misses and page faults per run
+	void setCounters(bool on) { useCounters = on; }
+
+	// out is called with every result as it finishes, default is to print a table row to cout
+	const std::vector<Result> &run(std::function<void (const Result &)> out = nullptr)
+	{
+		std::unique_ptr<PerfCounters> counters;
+		if (useCounters) {
+			counters = std::make_unique<PerfCounters>();
+			if (!counters->available()) {
+				std::cout << "performance counters not available (not Linux, no PMU, or perf_event_paranoid), timing only\n";
+				counters.reset();
+			} else if (!counters->hardware()) {
+				std::cout << "no hardware performance counters here (a VM?), only software ones\n";
+			}
+		}
+		if (out == nullptr)
+			printHeader(std::cout, counters != nullptr);
+		for (auto &c : cases) {
+			if (!filter.empty() && c.name.find(filter) == std::string::npos)
+				continue;
+			auto opts = c.opts;
+			if (forcedRuns > 0)
+				opts.runs = forcedRuns;
+			results.push_back(measure(c.name, c.body, opts, c.setup, c.teardown, counters.get()));
+			if (out != nullptr)
+				out(results.back());
+			else
+				printRow(std::cout, results.back(), counters != nullptr);
+		}
+		return results;
+	}
+
+	const std::vector<Result> &getResults() const { return results; }
+
+	static void printHeader(std::ostream &os, bool counters = false)
+	{
+		os << std::left << std::setw(nameWidth) << "benchmark" << std::right << std::setw(6) << "runs"
+			<< std::setw(12) << "min us" << std::setw(12) << "median us" << std::setw(12) << "p99 us" << std::setw(12) << "mean us" << std::setw(10) << "GB/s";
+		if (counters)
+			os << std::setw(8) << "IPC" << std::setw(9) << "B/cycle" << std::setw(12) << "cache miss" << std::setw(11) << "br miss" << std::setw(11) << "dTLB miss" << std::setw(9) << "faults";
+		os << "\n";
+	}
+
+	static void printRow(std::ostream &os, const Result &r, bool counters = false)
+	{
+		auto precision = os.precision();
+		os << std::left << std::setw(nameWidth) << r.name << std::right << std::setw(6) << r.runs << std::fixed << std::setprecision(2)
+			<< std::setw(12) << r.minUs << std::setw(12) << r.medianUs << std::setw(12) << r.p99Us << std::setw(12) << r.meanUs;
+		if (r.gbPerSec > 0)
+			os << std::setw(10) << r.gbPerSec;
+		else if (counters)
+			os << std::setw(10) << "";
+		if (counters) {
+			auto column = [&](int width, double v, int decimals) { // "-" for counters this machine doesn't have
+				if (v < 0)
+					os << std::setw(width) << "-";
+				else
+					os << std::setw(width) << std::setprecision(decimals) << v;
+			};
+			const auto &c = r.counters;
+			column(8, c.ipc(), 2);
+			column(9, c.bytesPerCycle(r.bytes), 2);
+			column(12, c.cacheMisses, 0);
+			column(11, c.branchMisses, 0);
+			column(11, c.dtlbMisses, 0);
+			column(9, c.pageFaults, 0);
+		}
+		os << "\n";
+		os.unsetf(std::ios::floatfield);
+		os.precision(precision);
+	}
+
+	void writeCsv(std::ostream &os) const
+	{
+		os << "name,runs,min_us,median_us,p99_us,mean_us,gb_per_s,cycles,instructions,cache_misses,branch_misses,llc_loads,dtlb_misses,page_faults,ipc,bytes_per_cycle\n";
+		for (auto &r : results) {
+			auto &c = r.counters;
+			os << '"' << escaped(r.name, '"') << "\"," << r.runs << ',' << r.minUs << ',' << r.medianUs << ',' << r.p99Us << ',' << r.meanUs << ',' << r.gbPerSec
+				<< ',' << c.cycles << ',' << c.instructions << ',' << c.cacheMisses << ',' << c.branchMisses << ',' << c.llcLoads << ',' << c.dtlbMisses << ',' << c.pageFaults
+				<< ',' << c.ipc() << ',' << c.bytesPerCycle(r.bytes) << "\n";
+		}
+	}
+
+	void writeJson(std::ostream &os) const
+	{
+		os << "[\n";
+		for (size_t i = 0; i < results.size(); i++) {
+			auto &r = results[i];
+			os << "  {\"name\": \"" << escaped(r.name, '\\') << "\", \"runs\": " << r.runs << ", \"min_us\": " << r.minUs << ", \"median_us\": " << r.medianUs
+				<< ", \"p99_us\": " << r.p99Us << ", \"mean_us\": " << r.meanUs << ", \"gb_per_s\": " << r.gbPerSec
+				<< ", \"cycles\": " << r.counters.cycles << ", \"instructions\": " << r.counters.instructions << ", \"cache_misses\": " << r.counters.cacheMisses
+				<< ", \"branch_misses\": " << r.counters.branchMisses << ", \"llc_loads\": " << r.counters.llcLoads << ", \"dtlb_misses\": " << r.counters.dtlbMisses << ", \"page_faults\": " << r.counters.pageFaults
+				<< ", \"ipc\": " << r.counters.ipc() << ", \"bytes_per_cycle\": " << r.counters.bytesPerCycle(r.bytes) << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		os << "]\n";
+	}
+
+private:
+	struct Case {
+		std::string name;
+		std::function<void()> body;
+		Options opts;
+		std::function<void()> setup;
+		std::function<void()> teardown;
+	};
+
+	static constexpr int nameWidth = 44;
+
+	// CSV escapes " as "", JSON escapes " and \ with a backslash
+	static std::string escaped(const std::string &s, char esc)
+	{
+		std::string out;
+		for (char c : s) {
+			if (c == '"' || (esc == '\\' && c == '\\'))
+				out += esc;
+			out += c;
+		}
+		return out;
+	}
+
+	Options defaults;
+	std::vector<Case> cases;
+	std::vector<Result> results;
+	std::string filter;
+	int forcedRuns = 0;
+	bool useCounters = false;
+};
+
+} // namespace bench
@@ -0,0 +1,194 @@
+#pragma once
+
+// Big buffers for the 20 MB benchmark blocks: aligned, on huge pages if wanted, faulted in up front and placed on a chosen NUMA node.
+//
+//	BigBuffer block(arraySize);													// 2 MB aligned, transparent huge pages, pre-faulted
+//	BigBuffer plain(arraySize, { 64, Pages::Small, false });					// what make_unique gives you, more or less
+//	vector<unsigned char, BigAllocator<unsigned char>> v(n, 0, BigAllocator<unsigned char>({ 64, Pages::Transparent }));
+//
+// Why: with 4 KB pages a 20 MB block is 5120 pages. That means 5120 page faults on first touch (in the first timed run if nobody touched it
+// before) and more pages than the TLB can map, so a linear pass misses the TLB every 4 KB. A 2 MB page covers 512 of them.
+//	Pages::Transparent	madvise(MADV_HUGEPAGE), the kernel uses 2 MB pages where it can (needs THP "madvise" or "always", the usual default)
+//	Pages::HugeTlb		mmap(MAP_HUGETLB), pages from the reserved hugetlbfs pool (vm.nr_hugepages). Falls back to Transparent when the pool is empty
+// numaNode >= 0 binds the pages to that node (mbind), so they end up there whichever thread touches them first. Nodes 0 to 63 (the mask is one
+// word), a higher one throws; a node this machine doesn't have leaves the default policy.
+// Everything but the alignment is Linux only, elsewhere it's an aligned operator new.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>	// MPOL_BIND
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class Pages { Small, Transparent, HugeTlb };
+
+inline const char *pagesName(Pages p)
+{
+	switch (p) {
+	case Pages::Small: return "4K pages";
+	case Pages::Transparent: return "THP";
+	case Pages::HugeTlb: return "hugetlb";
+	}
+	return "?";
+}
+
+struct BigOptions {
+	size_t align = 2 * 1024 * 1024;	// power of 2
+	Pages pages = Pages::Transparent;
+	bool prefault = true;			// touch every page now, so the faults aren't taken later in someone's timed region
+	int numaNode = -1;				// -1 = wherever the first touch happens (the default policy)
+};
+
+namespace detail {
+
+constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+// Size actually mapped for n bytes, what munmap needs back
+inline size_t bigMappedSize(size_t n, const BigOptions &opts)
+{
+	size_t unit = opts.pages == Pages::Small ? 4096 : hugePageSize;
+	return (std::max<size_t>(n, 1) + unit - 1) / unit * unit;
+}
+
+} // namespace detail
+
+// Returns memory aligned to opts.align (throws std::bad_alloc, or std::invalid_argument for a numaNode of 64 or more). used (if not null) gets the kind of pages asked for that worked out.
+inline void *allocateBig(size_t n, const BigOptions &opts = {}, Pages *used = nullptr)
+{
+	Pages got = opts.pages;
+#if defined(__linux__)
+	if (opts.numaNode >= int(sizeof(unsigned long) * 8)) // the node mask below is a single word
+		throw std::invalid_argument("allocateBig: numaNode must be below " + std::to_string(sizeof(unsigned long) * 8));
+	size_t size = detail::bigMappedSize(n, opts);
+	void *p = MAP_FAILED;
+	if (opts.pages == Pages::HugeTlb) {
+		p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0); // always 2 MB aligned
+		if (p == MAP_FAILED)
+			got = Pages::Transparent;
+	}
+	if (p == MAP_FAILED) {
+		// Map align more than needed and unmap what's in front of the first aligned address and after the end
+		size_t align = std::max<size_t>(opts.align, 4096);
+		void *raw = mmap(nullptr, size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (raw == MAP_FAILED)
+			throw std::bad_alloc();
+		uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+		uintptr_t aligned = (start + align - 1) & ~(uintptr_t(align) - 1);
+		if (aligned > start)
+			munmap(raw, aligned - start);
+		if (start + size + align > aligned + size)
+			munmap(reinterpret_cast<void *>(aligned + size), start + size + align - (aligned + size));
+		p = reinterpret_cast<void *>(aligned);
+		if (got == Pages::Transparent && madvise(p, size, MADV_HUGEPAGE) != 0)
+			got = Pages::Small; // kernel without THP
+	}
+	if (opts.numaNode >= 0) {
+		unsigned long mask = 1ul << opts.numaNode;
+		syscall(SYS_mbind, p, size, MPOL_BIND, &mask, sizeof(mask) * 8 + 1, 0); // maxnode is one more than the bits the kernel reads
+	}
+	if (opts.prefault) {
+		auto *bytes = static_cast<volatile unsigned char *>(p);
+		for (size_t i = 0; i < size; i += 4096) // one write per 4 KB page, a 2 MB page is faulted in whole by the first one
+			bytes[i] = 0;
+	}
+#else
+	void *p = ::operator new(n, std::align_val_t(opts.align));
+	got = Pages::Small;
+	if (opts.prefault)
+		std::memset(p, 0, n);
+#endif
+	if (used)
+		*used = got;
+	return p;
+}
+
+// n and opts as given to allocateBig
+inline void freeBig(void *p, size_t n, const BigOptions &opts = {})
+{
+	if (!p)
+		return;
+#if defined(__linux__)
+	munmap(p, detail::bigMappedSize(n, opts));
+#else
+	(void)n;
+	::operator delete(p, std::align_val_t(opts.align));
+#endif
+}
+
+// Owning buffer, move only
+class BigBuffer {
+public:
+	explicit BigBuffer(size_t n, BigOptions opts = {}) : n(n), opts(opts) { p = static_cast<unsigned char *>(allocateBig(n, opts, &got)); }
+	~BigBuffer() { freeBig(p, n, opts); }
+
+	BigBuffer(BigBuffer &&other) noexcept : p(std::exchange(other.p, nullptr)), n(other.n), opts(other.opts), got(other.got) {}
+	BigBuffer &operator=(BigBuffer &&other) noexcept
+	{
+		std::swap(p, other.p);
+		std::swap(n, other.n);
+		std::swap(opts, other.opts);
+		std::swap(got, other.got);
+		return *this;
+	}
+
+	unsigned char *data() const { return p; }
+	size_t size() const { return n; }
+	Pages pages() const { return got; }	// what was asked for, or what it fell back to
+
+private:
+	unsigned char *p = nullptr;
+	size_t n;
+	BigOptions opts;
+	Pages got = Pages::Small;
+};
+
+// std allocator on top of allocateBig, for vectors. Meant for a few big allocations, every allocate is at least one mmap
+template <typename T>
+class BigAllocator {
+public:
+	using value_type = T;
+
+	BigAllocator(BigOptions opts = {}) : opts(opts) {}
+	template <typename U>
+	BigAllocator(const BigAllocator<U> &other) : opts(other.opts) {}
+
+	T *allocate(size_t n) { return static_cast<T *>(allocateBig(n * sizeof(T), opts)); }
+	void deallocate(T *p, size_t n) { freeBig(p, n * sizeof(T), opts); }
+
+	// Any BigAllocator can free what another allocated, as long as the options that decide the mapped size and alignment match
+	template <typename U>
+	bool operator==(const BigAllocator<U> &other) const { return opts.pages == other.opts.pages && opts.align == other.opts.align; }
+	template <typename U>
+	bool operator!=(const BigAllocator<U> &other) const { return !(*this == other); }
+
+private:
+	template <typename U> friend class BigAllocator;
+	BigOptions opts;
+};
+
+// Resident set size of the whole process right now (not the peak, so it can be sampled before and during a run). 0 where there is no /proc
+inline size_t residentBytes()
+{
+#if defined(__linux__)
+	FILE *f = std::fopen("/proc/self/statm", "r");
+	if (!f)
+		return 0;
+	unsigned long long total = 0, resident = 0;
+	int got = std::fscanf(f, "%llu %llu", &total, &resident);
+	std::fclose(f);
+	return got == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+	return 0;
+#endif
+}
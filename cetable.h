@@ -0,0 +1,70 @@
+#pragma once
+
+// Compile-time lookup table generator, the generic version of struct A<N> in constexpr.cpp.
+// A<N> is hard wired to fibCE(i + 37) and its arr has to be copied out to a runtime array before use, this one takes
+// any constexpr generator, element type and index range and gives back a std::array, so it can be an inline constexpr global:
+//
+//	inline constexpr auto fibTable = makeTable<long, 37, 41>([](size_t i) { return fibFast(i); }); // fibTable[0] == F(37)
+//
+// The table lives in .rodata, nothing is computed or copied at start-up, and hot loops just index it instead of doing the math.
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+// Element i is gen(Begin + i), for i in [0, End - Begin)
+template <typename T, size_t Begin, size_t End, typename Gen>
+constexpr std::array<T, End - Begin> makeTable(Gen gen)
+{
+	static_assert(Begin <= End, "makeTable: empty or reversed index range");
+	std::array<T, End - Begin> table {}; // must be initialized for constexpr (same as the = {0} in A<N>)
+	for (size_t i = 0; i < table.size(); i++)
+		table[i] = static_cast<T>(gen(Begin + i)); // non-const std::array::operator[] is constexpr since C++17
+	return table;
+}
+
+// Shorthand for the common [0, N) case
+template <typename T, size_t N, typename Gen>
+constexpr std::array<T, N> makeTable(Gen gen)
+{
+	return makeTable<T, 0, N>(gen);
+}
+
+// Memoization for compile time: recursive definitions like fibCE recompute the same values over and over (exponential), and the constexpr
+// evaluator counts every one of those calls against -fconstexpr-ops-limit. With memoization each value is computed once, so it's linear.
+
+// Bottom-up: element i is f(table, i), and f may read the elements before i.
+//	inline constexpr auto fibs = makeRecurrenceTable<uint64_t, 94>([](const auto &t, size_t i) { return i < 2 ? i : t[i - 1] + t[i - 2]; });
+template <typename T, size_t N, typename F>
+constexpr std::array<T, N> makeRecurrenceTable(F f)
+{
+	std::array<T, N> table {};
+	for (size_t i = 0; i < N; i++)
+		table[i] = static_cast<T>(f(std::as_const(table), i));
+	return table;
+}
+
+// Top-down, for keeping a recursive definition as it is: f(recurse, i) computes value i and calls recurse(j) for the values it needs,
+// which are then computed once and remembered.
+//	ConstexprMemo<uint64_t, 94> memo;
+//	memo.get(40, [](auto fibOf, size_t i) -> uint64_t { return i < 2 ? i : fibOf(i - 1) + fibOf(i - 2); });
+// Every level of recursion is a few constexpr call levels, so deep first calls run into -fconstexpr-depth (512 by default) long before
+// the ops limit. Asking for the values in increasing order keeps it shallow, or use makeRecurrenceTable.
+template <typename T, size_t N>
+class ConstexprMemo {
+public:
+	template <typename F>
+	constexpr T get(size_t i, F f)
+	{
+		if (!known[i]) {
+			auto recurse = [this, &f](size_t j) { return get(j, f); };
+			values[i] = f(recurse, i);
+			known[i] = true;
+		}
+		return values[i];
+	}
+
+private:
+	T values[N] {};
+	bool known[N] {};
+};
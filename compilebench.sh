@@ -0,0 +1,104 @@
+#!/usr/bin/env bash
+
+# Compile time benchmark for constexpr tables: how long the compiler takes, and how much memory it needs, to build a table of the first N
+# fibonacci numbers (mod 2^64) at compile time, for growing N and four ways of computing it:
+#	naive		fibCE-style recursion per element, exponential as written. g++ caches constexpr call results, so it stays cheap there;
+#				compilers that don't (clang) hit -fconstexpr-steps in the 20s or 30s, reported as "limit". Only small N
+#	memo		ConstexprMemo (cetable.h), top-down recursion with memoization, values asked for in increasing order
+#	recurrence	makeRecurrenceTable (cetable.h), bottom-up, each element from the two before it
+#	fast		makeTable with fibFast (fib.h), O(log i) per element
+#
+#	./compilebench.sh									# default sizes, g++
+#	CXX=clang++ ./compilebench.sh
+#	NAIVE_SIZES="20 25 30" SIZES="1000 10000" ./compilebench.sh
+#
+# Memory is the max RSS from /usr/bin/time when there is one, otherwise what g++ -ftime-report says it allocated (GC memory, smaller than
+# the RSS but grows the same way), otherwise not shown. Only compiles (-c), the default limits are left alone on purpose: with g++ 12 -O2
+# fast runs into -fconstexpr-ops-limit somewhere below 50000 entries (each entry is its own O(log i) call), the recurrence is cheapest.
+
+set -u
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2 -std=c++17}
+NAIVE_SIZES=${NAIVE_SIZES:-"16 20 24 28 32"}
+SIZES=${SIZES:-"100 1000 10000 50000"}
+
+here=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/table.cpp" <<'EOF'
+#include <cstdint>
+#include "cetable.h"
+#include "fib.h"
+
+constexpr uint64_t fibNaive(size_t n) { return n <= 1 ? n : fibNaive(n - 1) + fibNaive(n - 2); }
+
+#if STRATEGY == 0
+inline constexpr auto table = makeTable<uint64_t, TABLE_SIZE>([](size_t i) { return fibNaive(i); });
+#elif STRATEGY == 1
+inline constexpr auto table = [] {
+	ConstexprMemo<uint64_t, TABLE_SIZE> memo;
+	std::array<uint64_t, TABLE_SIZE> t {};
+	for (size_t i = 0; i < TABLE_SIZE; i++)
+		t[i] = memo.get(i, [](auto fibOf, size_t j) -> uint64_t { return j < 2 ? j : fibOf(j - 1) + fibOf(j - 2); });
+	return t;
+}();
+#elif STRATEGY == 2
+inline constexpr auto table = makeRecurrenceTable<uint64_t, TABLE_SIZE>([](const auto &t, size_t i) { return i < 2 ? i : t[i - 1] + t[i - 2]; });
+#else
+inline constexpr auto table = makeTable<uint64_t, TABLE_SIZE>([](size_t i) { return fibFast<uint64_t>(static_cast<unsigned>(i)); });
+#endif
+
+uint64_t lookup(size_t i) { return table[i % TABLE_SIZE]; }	// so the table is used
+EOF
+
+if [ -x /usr/bin/time ]; then
+	memory="rss"
+elif "$CXX" --version 2>/dev/null | grep -qi "gcc\|g++\|free software"; then
+	memory="gcc"
+else
+	memory="none"
+fi
+
+# compile <strategy> <N>: prints seconds and memory, "limit" when the compiler gave up on the constexpr evaluation
+compile() {
+	local out start end secs mem=""
+	start=$(date +%s.%N)
+	case $memory in
+	rss)	out=$(/usr/bin/time -f "maxrss %M" "$CXX" $CXXFLAGS -I"$here" -DSTRATEGY="$1" -DTABLE_SIZE="$2" -c "$work/table.cpp" -o "$work/table.o" 2>&1) ;;
+	gcc)	out=$("$CXX" $CXXFLAGS -ftime-report -I"$here" -DSTRATEGY="$1" -DTABLE_SIZE="$2" -c "$work/table.cpp" -o "$work/table.o" 2>&1) ;;
+	*)		out=$("$CXX" $CXXFLAGS -I"$here" -DSTRATEGY="$1" -DTABLE_SIZE="$2" -c "$work/table.cpp" -o "$work/table.o" 2>&1) ;;
+	esac
+	local status=$?
+	end=$(date +%s.%N)
+	secs=$(awk -v s="$start" -v e="$end" 'BEGIN { printf "%.2f", e - s }')
+	if [ $status -ne 0 ]; then
+		if echo "$out" | grep -q "limit\|depth exceeds\|exceeds maximum"; then
+			printf "%8s s  %12s\n" "$secs" "limit"
+		else
+			printf "%8s s  %12s\n" "$secs" "error"
+			echo "$out" | head -5 >&2
+		fi
+		return
+	fi
+	case $memory in
+	rss)	mem="$(echo "$out" | awk '/maxrss/ { print $2 }') KB rss" ;;
+	gcc)	mem="$(echo "$out" | awk '/TOTAL/ { print $NF }') gc" ;;
+	esac
+	printf "%8s s  %12s\n" "$secs" "$mem"
+}
+
+names=(naive memo recurrence fast)
+echo "$CXX $CXXFLAGS"
+printf "%-12s %8s  %10s  %12s\n" "strategy" "N" "time" "memory"
+for n in $NAIVE_SIZES; do
+	printf "%-12s %8s  " naive "$n"
+	compile 0 "$n"
+done
+for s in 1 2 3; do
+	for n in $SIZES; do
+		printf "%-12s %8s  " "${names[$s]}" "$n"
+		compile "$s" "$n"
+	done
+done
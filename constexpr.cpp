@@ -3,6 +3,7 @@
 
 // MinGW was taking libstd++6.dll from Windows instead of the one in MinGW
 // -std=c++17 for fold expressions
+// -std=c++20 builds too, and adds the coroutine pipeline cases (coro.h)
 // -ID:\Code\boost_1_66_0 to include and use Boost code (just the template/header ones, need to link to libs for some Boost stuff, for that use -L )
 
 // On Linux, assuming no boost:
@@ -21,8 +22,40 @@
 #include <array>
 #include <cstring>					// memset etc (seems to be included by windows.h)
 #include <memory>					// unique_ptr etc
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <cstdlib>					// atoi
+#include <optional>
+#include <filesystem>				// temp_directory_path
+#include <random>					// mt19937, random inputs for the algo:: checks
+
+#include "bench.h"					// micro-benchmark harness (warm-up, repeated runs, min/median/p99, csv/json)
+#include "fib.h"					// fast doubling / memo / 128 bit / BigUint fibonacci
+#include "cetable.h"				// makeTable, constexpr lookup tables as std::array
+#include "fill.h"					// buf:: SSE2/AVX2/AVX-512 fill kernels with runtime cpu dispatch
+#include "threadpool.h"				// persistent ThreadPool with parallelFor
+#include "parbuf.h"					// par:: multithreaded fill/generate/transform over cache line aligned chunks
+#include "reduce.h"					// fold:: reductions over ranges, multi-accumulator simd kernels, Kahan/pairwise sums
+#include "appendbuf.h"				// lock-free AppendBuffer / SegmentedAppender
+#include "timerwheel.h"				// TimerWheel, hybridSleepUntil, JitterStats
+#include "executor.h"				// WorkStealingExecutor, Task<T> with then()
+#include "strbuilder.h"				// StringBuilder, Arena, ArenaStringBuilder
+#define ALLOC_COUNT_IMPLEMENTATION	// this file defines the counting operator new/delete
+#include "alloccount.h"				// per thread allocation counters
+#include "printbuf.h"				// out::print, FoldPrint into a thread local buffer with to_chars, one write(2) per line/batch
+#include "bigbuf.h"					// BigBuffer/BigAllocator: 2 MB aligned, huge pages, pre-faulted, NUMA node
+#include "mapfile.h"					// MappedFile: generate straight into a memory mapped file
+#include "smallvec.h"				// emplace_many (reserve once + perfect forwarding), SmallVector with inline storage
+#include "stripedlock.h"			// StripedLocks, SpinLock, AdaptiveMutex, CountedLock contention counters
+#include "palgo.h"					// algo:: parallel sort/merge/scan/find/set operations with seq/par/par_unseq policies
+#include "fixedops.h"				// fixed::copy/fill/transform<N>, unrolled for compile time sizes
+#include "funcref.h"				// function_ref, inplace_function: callbacks that never allocate
+#include "expected.h"				// err::expected<T>, errors as return values with an error code and a short message
+#include "coro.h"					// coro::generator, coro::task (C++20 only, CORO_AVAILABLE): the frame streamed in chunks
 
 //#include <execution> // for parallell execution of <algorithm>! Since C++ 17. Doesn't seem available for this g++ but available in Visual Studio.  Supposedly at least partially supported with gcc/g++ v10+
+// (libstdc++ needs TBB for it, so for the big buffers we use our own thread pool instead, see parbuf.h)
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
 #define USING_WIN_32
@@ -38,6 +71,8 @@
 
 #include <time.h>
 #include <errno.h>
+#include <fcntl.h>		// open, for the print benchmarks
+#include <unistd.h>		// dup/dup2
 
 /* Sleep(): Linux version of Windows Sleep, sleeps for the requested number of milliseconds. */
 /* sleep(n) sleeps for n seconds, usleep(microseconds e.g. n*1000) is deprecated, and nanosleep sleeps for nanoseconds(n*1000*1000) */
@@ -79,6 +114,17 @@ constexpr long int fibCE(int n)
 {
     return (n <= 1)? n : fibCE(n-1) + fibCE(n-2);
 }
+// Note: both of the above are exponential. fibCE(40) in a constexpr context exceeds g++'s default -fconstexpr-ops-limit (and took ~30s to compile when the limit was raised).
+// fibFast in fib.h does the same in O(log n), at runtime or compile time, so that is what the constexpr tables use now.
+
+// Or keep the recursion and memoize it (cetable.h): every F(i) is computed once, linear, so fibCEMemo(40) stays far below the default ops limit
+constexpr long int fibCEMemo(int n)
+{
+	ConstexprMemo<long int, 93> memo;
+	return memo.get(n, [](auto fibOf, size_t i) -> long int { return (i <= 1) ? i : fibOf(i - 1) + fibOf(i - 2); });
+}
+// The bottom-up version, a table of every fibonacci number that fits in 64 bits. compilebench.sh compares the compile cost of these
+inline constexpr auto fibRecurrenceTable = makeRecurrenceTable<uint64_t, 94>([](const auto &t, size_t i) { return i < 2 ? i : t[i - 1] + t[i - 2]; });
 
 
 // Instantiate a whole array of constexprs
@@ -87,11 +133,24 @@ template<int N>
 struct A { // using a class and setting all to public works just as well
     constexpr A() { // : arr() needed because it needs to be initialized for constexpr to work. Note: removed because initing to {0} below works as well
         for (auto i = 0; i != N; ++i)
-            arr[i] = fibCE(i + 37); // note, it is not allowed to call non-const-expr function from here (like fib instead of fibCE)
+            arr[i] = fibFast(i + 37); // note, it is not allowed to call non-const-expr function from here (like fib instead of fibCE). Used to be fibCE, see note above
     }
     int arr[N] = {0};
 };
 
+// Same thing with the generic table generator (cetable.h). No struct to construct and no copying out of arr, fibTable can be used directly
+inline constexpr auto fibTable = makeTable<int, 37, 41>([](size_t i) { return fibFast(i); });
+
+// A table that takes per-call math out of a hot loop: reversing the bits of a byte, once per byte of a 20 MB buffer
+constexpr unsigned char reverseBits(unsigned char b)
+{
+	unsigned char r = 0;
+	for (int i = 0; i < 8; i++)
+		r |= ((b >> i) & 1) << (7 - i);
+	return r;
+}
+inline constexpr auto reverseBitsTable = makeTable<unsigned char, 256>(reverseBits);
+
 
 
 template <typename... T>
@@ -121,7 +180,7 @@ template <typename T, typename... Args>
 void push_back_vec(vector<T> &v, Args&& ...args)
 {
 	(v.push_back(args) , ...); // comma separator makes e.g.: v.push_back(arg0),v.push_back(arg1),v.push_back(arg2);
-}
+} // copies every arg and may reallocate on the way, see emplace_many in smallvec.h (reserves once and forwards)
 
 
 struct foo {
@@ -177,42 +236,941 @@ __forceinline void fnoe() noexcept { // no more warning since we always catch ex
 	//} catch(std::exception e) { cout << "Caught it!\n"; } // this line doesn't catch the int exception, so program terminates. Warning does not show though
 }
 
-int main ()
+// fnoe without the exception (expected.h): the error is the return value, nothing is allocated and nothing unwinds
+err::expected<void> fnoeExpected() noexcept
+{
+	return err::fail(err::Errc::Other, "Err!");
+}
+
+// The error path benchmarks: the same little function fails for every failEvery'th i, by throwing like fnoe or by returning an error
+int parseThrowing(int i, int failEvery)
 {
-	auto timerFunc = [](auto f, std::function<void (long long)> out = nullptr) { // think I must use std::function here for arg2, since I wanted it to have nullptr as default value
-		using namespace std::chrono; // for the clocks, microseconds, duration_cast
-		auto start = high_resolution_clock::now();
+	if (failEvery && i % failEvery == 0)
+		throw std::string("Err!");
+	return i * 2;
+}
 
-		f();
+err::expected<int> parseExpected(int i, int failEvery) noexcept
+{
+	if (failEvery && i % failEvery == 0)
+		return err::fail(err::Errc::InvalidArgument, "Err!");
+	return i * 2;
+}
 
-		auto stop = high_resolution_clock::now();
-		auto diff = duration_cast<microseconds>(stop - start);
+// AppendBuffer (appendbuf.h) filled past its capacity: 4 threads append blocks of 3 values until one doesn't fit, then single values until
+// the buffer is full. Everything below size() has to be a value some append wrote, blocks whole and in one piece, and the singles have to
+// fill it up exactly (a block that didn't fit must not keep its slots). Returns false if any round breaks that
+bool checkAppendBufferOverflow(int rounds)
+{
+	const size_t capacity = 100; // not a multiple of 3, the last block never fits
+	const int writers = 4;
+	for (int round = 0; round < rounds; round++) {
+		AppendBuffer<int> ab(capacity);
+		atomic<size_t> appended { 0 };
+		vector<thread> threads;
+		for (int t = 0; t < writers; t++) {
+			threads.emplace_back([&, t]() {
+				for (int k = 0; ; k++) {
+					int base = (t * 1000 + k) * 3;
+					const int block[] = { base, base + 1, base + 2 };
+					if (!ab.append(block, 3))
+						break;
+					appended += 3;
+				}
+				while (ab.append(-1 - t))
+					appended++;
+			});
+		}
+		for (auto &th : threads)
+			th.join();
+		if (ab.size() != appended || ab.size() != capacity)
+			return false;
+		for (const int *p = ab.begin(); p < ab.end(); p += *p < 0 ? 1 : 3) {
+			if (*p < 0 ? *p < -writers : (*p % 3 != 0 || ab.end() - p < 3 || p[1] != *p + 1 || p[2] != *p + 2))
+				return false;
+		}
+	}
+	return true;
+}
 
-		if (out != nullptr)
-			out(diff.count());
-		else
-			cout << "Time spent: " << diff.count() << " ms\n";
+// algo:: (palgo.h) vs the serial std versions on random inputs, every other round with lots of duplicates. Runs on a pool of its own with
+// small chunks, so the chunk and piece boundaries get exercised even on a single core machine. Returns the names of the ones that differ
+vector<string> checkParallelAlgorithms(int rounds)
+{
+	ThreadPool pool(3);
+	mt19937 rng(99);
+	vector<string> failed;
+	auto check = [&](bool ok, const char *what) {
+		if (!ok && find(failed.begin(), failed.end(), what) == failed.end())
+			failed.push_back(what);
 	};
+	for (int r = 0; r < rounds; r++) {
+		size_t n = r < 4 ? r : rng() % 20000, m = rng() % 5000;
+		int range = r % 2 ? 50 : 1000000;
+		algo::ParallelPolicy policy { { &pool, 4 }, 1 + rng() % 500 };
+		algo::ParallelUnsequencedPolicy unseq;
+		unseq.cfg = policy.cfg;
+		unseq.grain = policy.grain;
+
+		vector<int> v(n), w(m);
+		for (auto &x : v)
+			x = static_cast<int>(rng() % range);
+		for (auto &x : w)
+			x = static_cast<int>(rng() % range);
+		std::sort(w.begin(), w.end());
+
+		auto expected = v, got = v;
+		std::sort(expected.begin(), expected.end());
+		algo::sort(policy, got.begin(), got.end());
+		check(got == expected, "sort");
+		const auto &sorted = expected;
+
+		vector<pair<int, int>> keyed(n), keyedStd; // stable: equal keys keep their original order
+		for (size_t i = 0; i < n; i++)
+			keyed[i] = { v[i] % 10, static_cast<int>(i) };
+		keyedStd = keyed;
+		auto byKey = [](const pair<int, int> &a, const pair<int, int> &b) { return a.first < b.first; };
+		std::stable_sort(keyedStd.begin(), keyedStd.end(), byKey);
+		algo::stable_sort(policy, keyed.begin(), keyed.end(), byKey);
+		check(keyed == keyedStd, "stable_sort");
+
+		vector<int64_t> sums(n), sumsStd(n);
+		std::inclusive_scan(v.begin(), v.end(), sumsStd.begin(), plus<>(), int64_t(0));
+		algo::inclusive_scan(policy, v.begin(), v.end(), sums.begin(), plus<>(), int64_t(0));
+		check(sums == sumsStd, "inclusive_scan");
+		std::exclusive_scan(v.begin(), v.end(), sumsStd.begin(), int64_t(7));
+		algo::exclusive_scan(unseq, v.begin(), v.end(), sums.begin(), int64_t(7));
+		check(sums == sumsStd, "exclusive_scan");
+
+		int target = n ? v[rng() % n] : 0;
+		check(algo::find(policy, v.begin(), v.end(), target) == std::find(v.begin(), v.end(), target), "find");
+		check(algo::find(policy, v.begin(), v.end(), -1) == v.end(), "find");
+		auto pred = [](int x) { return x % 7 == 3; };
+		check(algo::count_if(unseq, v.begin(), v.end(), pred) == static_cast<size_t>(std::count_if(v.begin(), v.end(), pred)), "count_if");
+		check(algo::any_of(policy, v.begin(), v.end(), pred) == std::any_of(v.begin(), v.end(), pred), "any_of");
+		check(algo::reduce(policy, v.begin(), v.end(), int64_t(3)) == std::accumulate(v.begin(), v.end(), int64_t(3)), "reduce");
+		vector<int> mapped(n), mappedStd(n);
+		std::transform(v.begin(), v.end(), mappedStd.begin(), [](int x) { return x * 3 + 1; });
+		algo::transform(unseq, v.begin(), v.end(), mapped.begin(), [](int x) { return x * 3 + 1; });
+		check(mapped == mappedStd, "transform");
+
+		vector<int> out(n + m), outStd(n + m);
+		std::merge(sorted.begin(), sorted.end(), w.begin(), w.end(), outStd.begin());
+		algo::merge(policy, sorted.begin(), sorted.end(), w.begin(), w.end(), out.begin());
+		check(out == outStd, "merge");
+		// Both ways round, the cut values come from the longer range
+		auto checkSet = [&](const char *what, auto stdOp, auto algoOp) {
+			for (bool swapped : { false, true }) {
+				const auto &a = swapped ? w : sorted, &b = swapped ? sorted : w;
+				auto endStd = stdOp(a.begin(), a.end(), b.begin(), b.end(), outStd.begin());
+				auto end = algoOp(policy, a.begin(), a.end(), b.begin(), b.end(), out.begin());
+				check(end - out.begin() == endStd - outStd.begin() && equal(outStd.begin(), endStd, out.begin()), what);
+			}
+		};
+		checkSet("set_union", [](auto... args) { return std::set_union(args...); }, [](auto... args) { return algo::set_union(args...); });
+		checkSet("set_intersection", [](auto... args) { return std::set_intersection(args...); }, [](auto... args) { return algo::set_intersection(args...); });
+		checkSet("set_difference", [](auto... args) { return std::set_difference(args...); }, [](auto... args) { return algo::set_difference(args...); });
+		checkSet("set_symmetric_difference", [](auto... args) { return std::set_symmetric_difference(args...); },
+			[](auto... args) { return algo::set_symmetric_difference(args...); });
+	}
+	return failed;
+}
 
-	auto printTimer = [](long long timeSpent) { cout << "That took: " << timeSpent << " MICRO seconds (not milli)\n"; };
+// The 20 MB frame through three stages, generate (i%256) -> reverse the bits -> write to a file. Eager: each stage over the whole frame, in a
+// fresh frame sized buffer. Streamed (coro.h): a chunk goes through all three before the next one is generated, so only a chunk or two is
+// ever held, and a chunk is still in the cache when it's transformed. peak gets the most the resident size grew during the run.
+size_t residentGrowth(size_t base)
+{
+	size_t now = residentBytes();
+	return now > base ? now - base : 0;
+}
 
-    long int res = fib(35);
-	timerFunc([&]() { res = fib(35); }, printTimer );
-    cout << res << "\n";
+void reverseBitsInPlace(unsigned char *p, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		p[i] = reverseBitsTable[p[i]];
+}
 
-	timerFunc([&]() { constexpr long int tmp = fibCE(40); res = tmp; }, printTimer ); //Seems also for g++, in some cases result var must be tagged as constexpr too (like here) to be precomputed. So always do that!
-    cout << res << "\n";
+void frameEager(const string &path, size_t total, size_t &peak)
+{
+	size_t base = residentBytes();
+	BigBuffer frame(total, { 64, Pages::Small, false }); // untouched like a new[] of that size, its pages become resident as the fill gets to them
+	buf::fillRamp(frame.data(), total);
+	reverseBitsInPlace(frame.data(), total);
+	peak = std::max(peak, residentGrowth(base));
+	ofstream f(path, ios::binary | ios::trunc);
+	f.write(reinterpret_cast<const char *>(frame.data()), total);
+}
+
+#if defined(CORO_AVAILABLE)
+struct FrameChunk {
+	unsigned char *data;
+	size_t size;
+};
+
+// Chunks of the frame, rotating through the caller's `buffers` chunk buffers (storage, buffers * chunkSize bytes): a buffer is filled again
+// `buffers` chunks later, by then its consumer has to be done with it. The caller owns them so they can outlive the generator, for a
+// consumer that still uses the last chunk after the loop has run the generator to its end
+coro::generator<FrameChunk> frameChunks(unsigned char *storage, size_t total, size_t chunkSize, size_t buffers)
+{
+	for (size_t done = 0, i = 0; done < total; done += chunkSize, i++) {
+		size_t n = std::min(chunkSize, total - done);
+		unsigned char *p = storage + (i % buffers) * chunkSize;
+		buf::fillRamp(p, n, static_cast<uint8_t>(done)); // the ramp continues where the last chunk stopped
+		co_yield FrameChunk { p, n };
+	}
+}
+
+void frameStreamed(const string &path, size_t total, size_t chunkSize, size_t &peak)
+{
+	size_t base = residentBytes(), i = 0;
+	ofstream f(path, ios::binary | ios::trunc);
+	vector<unsigned char> storage(chunkSize);
+	for (FrameChunk c : frameChunks(storage.data(), total, chunkSize, 1)) {
+		reverseBitsInPlace(c.data, c.size);
+		f.write(reinterpret_cast<const char *>(c.data), c.size);
+		if (i++ % 16 == 0) // reading /proc costs a few us, not every chunk
+			peak = std::max(peak, residentGrowth(base));
+	}
+}
+
+coro::task<void> writeChunk(ofstream &f, FrameChunk c, WorkStealingExecutor &ex)
+{
+	co_await coro::resumeOn(ex);
+	f.write(reinterpret_cast<const char *>(c.data), c.size);
+}
+
+// Same, but the write of a chunk runs on an executor worker while the next chunk is generated and transformed. One write at a time: chunk k
+// is written while k + 1 is generated into the other of two buffers, and k's write is awaited before k + 2 goes into its buffer. The last
+// write is still running when the loop's ++ finishes the generator, which is why the buffers live here and not in frameChunks
+coro::task<void> frameStreamedAsync(const string &path, size_t total, size_t chunkSize, WorkStealingExecutor &ex, size_t &peak)
+{
+	size_t base = residentBytes(), i = 0;
+	ofstream f(path, ios::binary | ios::trunc);
+	vector<unsigned char> storage(chunkSize * 2);
+	coro::task<void> writing;
+	for (FrameChunk c : frameChunks(storage.data(), total, chunkSize, 2)) {
+		reverseBitsInPlace(c.data, c.size);
+		if (writing)
+			co_await writing;
+		writing = writeChunk(f, c, ex);
+		writing.start();
+		if (i++ % 16 == 0)
+			peak = std::max(peak, residentGrowth(base));
+	}
+	if (writing)
+		co_await writing;
+}
+#endif
+
+int main (int argc, char *argv[])
+{
+	// Command line:  [--filter <substring>] [--runs <n>] [--csv <file>] [--json <file>] [--counters 1]
+	// e.g. "./constexpr.exe --filter fill --csv gcc12.csv" to only run the buffer fill cases and save them for comparing against another compiler
+	// --counters 1 adds hardware counters per case (IPC, bytes/cycle, cache/branch misses, page faults), Linux only, see perfcounters.h
+	string filter, csvFile, jsonFile;
+	int runs = 0;
+	bool counters = false;
+	for (int a = 1; a + 1 < argc; a += 2) {
+		string opt = argv[a];
+		if (opt == "--filter") filter = argv[a + 1];
+		else if (opt == "--runs") runs = atoi(argv[a + 1]);
+		else if (opt == "--csv") csvFile = argv[a + 1];
+		else if (opt == "--json") jsonFile = argv[a + 1];
+		else if (opt == "--counters") counters = atoi(argv[a + 1]) != 0;
+	}
+
+	bench::Suite suite; // all timing goes through this now (warm-up, repeated runs, min/median/p99), see bench.h
+	suite.setFilter(filter);
+	suite.setRuns(runs);
+	suite.setCounters(counters);
+
+	// Naive vs fast fibonacci side by side. fibN is volatile so the runtime versions can't be constant folded
+	volatile int fibN = 35, fibBigN = 10000;
+	long int res = fib(35);
+	uint64_t resFast = 0;
+	FibMemo<> fibMemo;
+	suite.add("fib(35) naive", [&]() { res = fib(fibN); bench::doNotOptimize(res); }, { 1, 5 });
+	suite.add("fibFast(35) fast doubling", [&]() { resFast = fibFast(fibN); bench::doNotOptimize(resFast); });
+	suite.add("FibMemo(35) memo lookup", [&]() { resFast = fibMemo.get(fibN); bench::doNotOptimize(resFast); });
+	suite.add("fibCE(25) naive constexpr", [&]() { constexpr long int tmp = fibCE(25); res = tmp; bench::doNotOptimize(res); }); // fibCE(40) here used to need -fconstexpr-ops-limit, see note at fibCE
+	suite.add("fibCEMemo(40) memoized constexpr", [&]() { constexpr long int tmp = fibCEMemo(40); res = tmp; bench::doNotOptimize(res); });
+	suite.add("fibFast(40) constexpr", [&]() { constexpr long int tmp = fibFast(40); res = tmp; bench::doNotOptimize(res); }); //Seems also for g++, in some cases result var must be tagged as constexpr too (like here) to be precomputed. So always do that!
+	suite.add("fibBig(10000)", [&]() { auto big = fibBig(fibBigN); bench::doNotOptimize(big); }, { 1, 5 });
 
-	// timerFunc([&]() { constexpr auto a = A<4>(); }, printTimer ); // ok, but how to use a outside of lambda?
 	const int arrSize = 4;
-	int arr[arrSize];
-	timerFunc([&]() { constexpr auto tmp = A<arrSize>(); for(int i = 0; i < arrSize; i++) arr[i] = tmp.arr[i]; }, printTimer ); // one way, but not using struct A type for actual results (as they are created in constructor)
+	int arr[arrSize] = {0};
+	suite.add("A<4> constexpr table copy", [&]() { constexpr auto tmp = A<arrSize>(); for(int i = 0; i < arrSize; i++) arr[i] = tmp.arr[i]; bench::doNotOptimize(arr); }); // one way, but not using struct A type for actual results (as they are created in constructor)
+	suite.add("A<4> constexpr table fixed::copy", [&]() { constexpr auto tmp = A<arrSize>(); fixed::copy(arr, tmp.arr); bench::doNotOptimize(arr); });
+	int fibTableSum = 0;
+	suite.add("fibTable constexpr global", [&]() { for (auto x : fibTable) fibTableSum += x; bench::doNotOptimize(fibTableSum); }); // no temporary A and no copy, the table is just there
+
+	// Loops with a runtime bound vs fixed:: kernels with N a template parameter (fixedops.h), 4 to 4096 ints. Every case does 4M elements
+	// in total, many short loops for the small sizes. The runtime n goes through doNotOptimize so the compiler can't turn it into a constant
+	alignas(64) static int fixedSrc[4096], fixedDst[4096];
+	for (int i = 0; i < 4096; i++)
+		fixedSrc[i] = i;
+	auto addFixedSize = [&](auto size) {
+		constexpr size_t N = decltype(size)::value;
+		const size_t reps = (size_t(1) << 22) / N;
+		string suffix = " " + to_string(N) + " ints";
+		size_t n = N;
+		auto triple = [](int x) { return x * 3 + 1; };
+		suite.add("fixed runtime n copy" + suffix, [=]() mutable {
+			for (size_t r = 0; r < reps; r++) {
+				bench::doNotOptimize(n);
+				for (size_t i = 0; i < n; i++)
+					fixedDst[i] = fixedSrc[i];
+				bench::doNotOptimize(fixedDst);
+			}
+		});
+		suite.add("fixed copy<N>" + suffix, [=]() { for (size_t r = 0; r < reps; r++) { fixed::copy<N>(fixedDst, fixedSrc); bench::doNotOptimize(fixedDst); } });
+		suite.add("fixed runtime n fill" + suffix, [=]() mutable {
+			for (size_t r = 0; r < reps; r++) {
+				bench::doNotOptimize(n);
+				for (size_t i = 0; i < n; i++)
+					fixedDst[i] = 0x77;
+				bench::doNotOptimize(fixedDst);
+			}
+		});
+		suite.add("fixed fill<N>" + suffix, [=]() { for (size_t r = 0; r < reps; r++) { fixed::fill<N>(fixedDst, 0x77); bench::doNotOptimize(fixedDst); } });
+		suite.add("fixed runtime n transform" + suffix, [=]() mutable {
+			for (size_t r = 0; r < reps; r++) {
+				bench::doNotOptimize(n);
+				for (size_t i = 0; i < n; i++)
+					fixedDst[i] = triple(fixedSrc[i]);
+				bench::doNotOptimize(fixedDst);
+			}
+		});
+		suite.add("fixed transform<N>" + suffix, [=]() { for (size_t r = 0; r < reps; r++) { fixed::transform<N>(fixedDst, fixedSrc, triple); bench::doNotOptimize(fixedDst); } });
+	};
+	addFixedSize(integral_constant<size_t, 4>());
+	addFixedSize(integral_constant<size_t, 16>());
+	addFixedSize(integral_constant<size_t, 64>());
+	addFixedSize(integral_constant<size_t, 256>());
+	addFixedSize(integral_constant<size_t, 1024>());
+	addFixedSize(integral_constant<size_t, 4096>());
+
+	const int arraySize = 1920 * 1080 * 10;
+
+	// Note: Interesting, using no -O option, memset is CLEARLY the fastest! But using -O3, all four solutions are typically very similar in speed (fastest one varies)! Wouuld be interesting to try execution::par
+	// (Why: at -O3 all four compile to vector stores, and 20 MB doesn't fit in the cache, so they all wait on the same memory bandwidth. --counters 1
+	// shows it, same bytes/cycle and a low IPC for each)
+	// The blocks are allocated once and reused by all cases, the warm-up runs take the page faults so they are not part of the timed runs
+	auto unique_block = make_unique<unsigned char []>(arraySize);
+	unsigned char *pBlock = unique_block.get();
+	auto vec_block = vector<unsigned char>(arraySize);
+	bench::Options bufOpts { 2, 15, arraySize }; // also report GB/s
+
+	suite.add("fill std::fill", [&]() { std::fill(pBlock, pBlock + arraySize, 0x77); bench::doNotOptimize(pBlock); }, bufOpts);
+	suite.add("fill memset", [&]() { memset(pBlock, 0x77, arraySize * sizeof(unsigned char)); bench::doNotOptimize(pBlock); }, bufOpts);
+	suite.add("fill byte loop", [&]() { unsigned char *p = pBlock; for (int i = 0; i < arraySize; i++) *p++ = 0x77; bench::doNotOptimize(pBlock); }, bufOpts);
+	suite.add("fill std::fill vector", [&]() { std::fill(vec_block.begin(), vec_block.end(), 0x77); bench::doNotOptimize(vec_block.data()); }, bufOpts); // time-wise, pretty much the same
+
+	suite.add("generate std::generate i%256", [&]() { int i = 0; std::generate(pBlock, pBlock + arraySize, [&i]() { return (i++) % 256; } ); bench::doNotOptimize(pBlock); }, bufOpts);
+	suite.add("generate byte loop i%256", [&]() { unsigned char *p = pBlock; for (int i = 0; i < arraySize; i++) *p++ = i % 256; bench::doNotOptimize(pBlock); }, bufOpts);
+	suite.add("generate std::generate vector i%256", [&]() { int i = 0; std::generate(vec_block.begin(), vec_block.end(), [&i]() { return (i++) % 256; } ); bench::doNotOptimize(vec_block.data()); }, bufOpts); // time-wise, pretty much the same
+
+	// The same fills/generates with the simd kernels from fill.h, for every isa this cpu has (buf::fillConst etc without a kernel argument use the best one)
+	const unsigned char pattern3[] = { 0x10, 0x20, 0x30 };
+	suite.add("generate std::generate 3 byte pattern", [&]() { int i = 0; std::generate(pBlock, pBlock + arraySize, [&]() { return pattern3[(i++) % 3]; } ); bench::doNotOptimize(pBlock); }, bufOpts);
+	for (auto isa : { buf::Isa::Scalar, buf::Isa::SSE2, buf::Isa::AVX2, buf::Isa::AVX512 }) {
+		if (!buf::isaSupported(isa))
+			continue;
+		auto k = buf::kernelsFor(isa);
+		string name = buf::isaName(isa);
+		suite.add("fill buf::fillConst " + name, [=]() { buf::fillConst(pBlock, 0x77, arraySize, k, buf::Store::Temporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("fill buf::fillConst NT " + name, [=]() { buf::fillConst(pBlock, 0x77, arraySize, k, buf::Store::NonTemporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("generate buf::fillRamp i%256 " + name, [=]() { buf::fillRamp(pBlock, arraySize, 0, k, buf::Store::Temporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("generate buf::fillRamp i%256 NT " + name, [=]() { buf::fillRamp(pBlock, arraySize, 0, k, buf::Store::NonTemporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("generate buf::fillPattern 3 bytes " + name, [=, &pattern3]() { buf::fillPattern(pBlock, arraySize, pattern3, sizeof(pattern3), k); bench::doNotOptimize(pBlock); }, bufOpts);
+	}
+
+	// Page faults and TLB misses (bigbuf.h, see them with --counters 1). A fresh 20 MB block takes a fault per 4 KB page (about 5000) in the fill that
+	// touches it first; with transparent huge pages that's 10 faults of 2 MB, and a pre-faulted BigBuffer has taken them all before the timer starts.
+	// (new[]/make_unique wouldn't show it reliably, malloc hands the same already faulted memory back after the first free)
+	optional<BigBuffer> freshBig;
+	for (auto pages : { Pages::Small, Pages::Transparent }) {
+		for (bool prefault : { false, true }) {
+			suite.add(string("fill fresh BigBuffer ") + pagesName(pages) + (prefault ? " prefaulted" : ""), [&]() { buf::fillConst(freshBig->data(), 0x77, arraySize); bench::doNotOptimize(freshBig->data()); },
+				{ 1, 10, arraySize }, [&, pages, prefault]() { freshBig.emplace(arraySize, BigOptions { pages == Pages::Small ? size_t(64) : size_t(2 * 1024 * 1024), pages, prefault }); }, [&]() { freshBig.reset(); });
+		}
+	}
+	// Once the pages are there: a linear fill barely notices the page size, random reads over 20 MB miss the TLB on most accesses with 4 KB pages
+	BigBuffer hugeBlock(arraySize);
+	vector<uint32_t> randomOffsets(1 << 20);
+	for (size_t i = 0; i < randomOffsets.size(); i++)
+		randomOffsets[i] = static_cast<uint32_t>((i * 2654435761u) % arraySize); // multiplicative hash, spread over the whole block
+	auto randomReads = [&](const unsigned char *p) { unsigned sum = 0; for (auto o : randomOffsets) sum += p[o]; bench::doNotOptimize(sum); };
+	suite.add("fill buf::fillConst 4K pages", [&]() { buf::fillConst(pBlock, 0x77, arraySize); bench::doNotOptimize(pBlock); }, bufOpts);
+	suite.add(string("fill buf::fillConst BigBuffer ") + pagesName(hugeBlock.pages()), [&]() { buf::fillConst(hugeBlock.data(), 0x77, arraySize); bench::doNotOptimize(hugeBlock.data()); }, bufOpts);
+	suite.add("random reads 1M 4K pages", [&]() { randomReads(pBlock); });
+	suite.add(string("random reads 1M BigBuffer ") + pagesName(hugeBlock.pages()), [&]() { randomReads(hugeBlock.data()); });
+
+	// Keeping the generated frame: fill a heap buffer then write() it to a file, vs generating straight into the mapped file (mapfile.h), no copy
+	// and no heap buffer. Both leave the data in the page cache for the kernel to write back; the msync/fsync cases wait until it's on disk
+	string framePath = (filesystem::temp_directory_path() / "constexpr_frame.raw").string();
+	suite.add("output fill + write", [&]() {
+		buf::fillRamp(pBlock, arraySize);
+		ofstream f(framePath, ios::binary | ios::trunc);
+		f.write(reinterpret_cast<const char *>(pBlock), arraySize);
+	}, bufOpts);
+	suite.add("output mmap fill", [&]() {
+		MappedFile f(framePath, arraySize);
+		f.advise(MapAdvice::Sequential);
+		buf::fillRamp(f.data(), arraySize);
+	}, bufOpts);
+	suite.add("output mmap par::fillRamp", [&]() {
+		MappedFile f(framePath, arraySize);
+		par::fillRamp(f.data(), arraySize);
+	}, bufOpts);
+#if !defined(USING_WIN_32)
+	suite.add("output fill + write + fsync", [&]() {
+		buf::fillRamp(pBlock, arraySize);
+		int fd = open(framePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		for (size_t done = 0; done < size_t(arraySize);) {
+			ssize_t w = write(fd, pBlock + done, arraySize - done);
+			if (w <= 0)
+				break;
+			done += w;
+		}
+		fsync(fd);
+		close(fd);
+	}, { 1, 5, arraySize });
+#endif
+	suite.add("output mmap fill + msync", [&]() {
+		MappedFile f(framePath, arraySize);
+		buf::fillRamp(f.data(), arraySize);
+		f.sync();
+	}, { 1, 5, arraySize });
+
+	// Generate -> transform -> write, the whole frame per stage vs streamed through coroutines a chunk at a time (coro.h, C++20 only). Same
+	// bytes end up in the file; the resident size each one needed is printed after the run
+	string pipelinePath = (filesystem::temp_directory_path() / "constexpr_pipeline.raw").string();
+	vector<pair<string, optional<size_t>>> pipelinePeaks; // empty for the cases the filter skipped
+	pipelinePeaks.reserve(8); // the cases keep references to their entries
+	auto addPipeline = [&](const string &name, auto run) {
+		optional<size_t> &peak = pipelinePeaks.emplace_back(name, nullopt).second;
+		suite.add("pipeline " + name, [&peak, run]() {
+			size_t p = peak.value_or(0);
+			run(p);
+			peak = p;
+		}, { 1, 10, arraySize });
+	};
+	addPipeline("eager", [&](size_t &peak) { frameEager(pipelinePath, arraySize, peak); });
+#if defined(CORO_AVAILABLE)
+	WorkStealingExecutor pipelineWriter(2); // the async case's writes, and the worker that continues after one of them
+	for (size_t chunk : { 64 * 1024, 256 * 1024, 1024 * 1024 }) {
+		string kb = to_string(chunk / 1024) + " KB chunks";
+		addPipeline("coro::generator " + kb, [&, chunk](size_t &peak) { frameStreamed(pipelinePath, arraySize, chunk, peak); });
+		addPipeline("coro::generator + task write " + kb, [&, chunk](size_t &peak) { coro::sync_wait(frameStreamedAsync(pipelinePath, arraySize, chunk, pipelineWriter, peak)); });
+	}
+#endif
+
+	// What the big fill does to everyone else: a workload that lives in L2 (summing a 256 KB table), alone and while another thread keeps
+	// filling the 20 MB block with normal stores (evicts the table, and the read-for-ownership traffic eats bandwidth) or streaming stores
+	vector<int> resident(64 * 1024, 1);
+	long long residentSum = 0;
+	auto residentWork = [&]() { for (int pass = 0; pass < 100; pass++) for (int x : resident) residentSum += x; bench::doNotOptimize(residentSum); };
+	auto otherBlock = make_unique<unsigned char []>(arraySize); // the background fill must not write the block the foreground cases use
+	unsigned char *pOther = otherBlock.get();
+	bench::BackgroundLoad temporalFill([=]() { buf::fillConst(pOther, 0x55, arraySize, buf::kernels(), buf::Store::Temporal); });
+	bench::BackgroundLoad streamingFill([=]() { buf::fillConst(pOther, 0x55, arraySize, buf::kernels(), buf::Store::NonTemporal); });
+	suite.add("cache resident sum alone", residentWork);
+	suite.add("cache resident sum + temporal fill", residentWork, {}, [&]() { temporalFill.start(); }, [&]() { temporalFill.stop(); });
+	suite.add("cache resident sum + non-temporal fill", residentWork, {}, [&]() { streamingFill.start(); }, [&]() { streamingFill.stop(); });
+
+	// Multithreaded versions (parbuf.h, persistent thread pool), scaling from 1 thread up to all cores
+	unsigned cores = ThreadPool::global().workers() + 1;
+	for (unsigned threads = 1; ; threads = std::min(threads * 2, cores)) {
+		par::Config cfg { nullptr, threads };
+		string name = " " + to_string(threads) + "t";
+		suite.add("fill par::fill" + name, [=]() { par::fill(pBlock, 0x77, arraySize, cfg, buf::Store::Temporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("fill par::fill NT" + name, [=]() { par::fill(pBlock, 0x77, arraySize, cfg, buf::Store::NonTemporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("generate par::fillRamp i%256" + name, [=]() { par::fillRamp(pBlock, arraySize, 0, cfg, buf::Store::Temporal); bench::doNotOptimize(pBlock); }, bufOpts);
+		suite.add("generate par::generate (i++)%256" + name, [=]() {
+			par::generate(pBlock, arraySize, [](size_t start) { return [i = start]() mutable { return (i++) % 256; }; }, cfg); // each chunk starts its own i at the chunk offset
+			bench::doNotOptimize(pBlock);
+		}, bufOpts);
+		suite.add("transform par::transform reverse bits" + name, [=]() { par::transform(pBlock, pBlock, arraySize, [](unsigned char b) { return reverseBitsTable[b]; }, cfg); bench::doNotOptimize(pBlock); }, bufOpts);
+		if (threads == cores)
+			break;
+	}
+
+	// Reductions over the 20 MB buffers (reduce.h), the runtime counterpart of the sum() fold: bytes summed in 64 bits, min/xor, and floats
+	uint64_t byteSum = 0;
+	unsigned char byteMin = 0, byteXor = 0;
+	suite.add("reduce std::accumulate bytes", [&]() { byteSum = std::accumulate(pBlock, pBlock + arraySize, uint64_t(0)); bench::doNotOptimize(byteSum); }, bufOpts);
+	suite.add("reduce fold::reduce + bytes", [&]() { byteSum = fold::reduce<uint64_t>(pBlock, arraySize, fold::Plus {}); bench::doNotOptimize(byteSum); }, bufOpts);
+	suite.add("reduce fold::reduce min bytes", [&]() { byteMin = fold::reduce(pBlock, arraySize, fold::Min {}); bench::doNotOptimize(byteMin); }, bufOpts);
+	suite.add("reduce fold::reduce xor bytes", [&]() { byteXor = fold::reduce(pBlock, arraySize, fold::BitXor {}); bench::doNotOptimize(byteXor); }, bufOpts);
+	suite.add("reduce fold::reduce + bytes parallel", [&]() { byteSum = fold::reduce<uint64_t>(fold::parallel, pBlock, arraySize, fold::Plus {}); bench::doNotOptimize(byteSum); }, bufOpts);
+
+	vector<float> floats(arraySize / sizeof(float));
+	for (size_t i = 0; i < floats.size(); i++)
+		floats[i] = 0.1f + (i % 1000) * 1e-4f; // lots of small terms, where a float running sum loses digits
+	double floatRef = 0;
+	for (float x : floats)
+		floatRef += x;
+	float floatLoop = 0, floatLanes = 0, floatKahan = 0, floatPairwise = 0;
+	suite.add("reduce float loop", [&]() { float s = 0; for (float x : floats) s += x; floatLoop = s; bench::doNotOptimize(floatLoop); }, bufOpts);
+	suite.add("reduce fold::reduce + float", [&]() { floatLanes = fold::reduce(floats.data(), floats.size(), fold::Plus {}); bench::doNotOptimize(floatLanes); }, bufOpts);
+	suite.add("reduce fold::sumKahan float", [&]() { floatKahan = fold::sumKahan(floats.data(), floats.size()); bench::doNotOptimize(floatKahan); }, bufOpts);
+	suite.add("reduce fold::sumPairwise float", [&]() { floatPairwise = fold::sumPairwise(floats.data(), floats.size()); bench::doNotOptimize(floatPairwise); }, bufOpts);
+	suite.add("reduce fold::sumKahan float parallel", [&]() { floatKahan = fold::sumKahan(fold::parallel, floats.data(), floats.size()); bench::doNotOptimize(floatKahan); }, bufOpts);
+
+	// Some of the <algorithm> families from the list at the end of main(), std vs algo:: (palgo.h) on 1M random ints.
+	// The sorts get the unsorted input copied back before every run (setup, not timed)
+	const size_t algoN = 1 << 20;
+	vector<int> algoInput(algoN), algoOther(algoN / 2);
+	{
+		mt19937 rng(1234);
+		for (auto &x : algoInput)
+			x = static_cast<int>(rng() % 1000000);
+		for (auto &x : algoOther)
+			x = static_cast<int>(rng() % 1000000);
+		algoInput[algoN / 50] = -1; // what find_if looks for, 2% in
+		std::sort(algoOther.begin(), algoOther.end());
+	}
+	vector<int> algoWork, algoSorted(algoInput), algoOut(algoN + algoN / 2);
+	vector<int64_t> algoSums(algoN);
+	std::sort(algoSorted.begin(), algoSorted.end());
+	auto resetAlgoWork = [&]() { algoWork = algoInput; };
+	bench::Options algoOpts { 1, 5 };
+	auto isNegative = [](int x) { return x < 0; };
+	auto isOdd = [](int x) { return (x & 1) != 0; };
+	suite.add("algo std::sort 1M ints", [&]() { std::sort(algoWork.begin(), algoWork.end()); }, algoOpts, resetAlgoWork);
+	suite.add("algo algo::sort par 1M ints", [&]() { algo::sort(algo::par, algoWork.begin(), algoWork.end()); }, algoOpts, resetAlgoWork);
+	suite.add("algo std::stable_sort 1M ints", [&]() { std::stable_sort(algoWork.begin(), algoWork.end()); }, algoOpts, resetAlgoWork);
+	suite.add("algo algo::stable_sort par 1M ints", [&]() { algo::stable_sort(algo::par, algoWork.begin(), algoWork.end()); }, algoOpts, resetAlgoWork);
+	suite.add("algo std::inclusive_scan 1M ints", [&]() { std::inclusive_scan(algoInput.begin(), algoInput.end(), algoSums.begin(), plus<>(), int64_t(0)); }, algoOpts);
+	suite.add("algo algo::inclusive_scan par 1M ints", [&]() { algo::inclusive_scan(algo::par, algoInput.begin(), algoInput.end(), algoSums.begin(), plus<>(), int64_t(0)); }, algoOpts);
+	suite.add("algo std::find_if 1M ints", [&]() { bench::doNotOptimize(std::find_if(algoInput.begin(), algoInput.end(), isNegative)); }, algoOpts);
+	suite.add("algo algo::find_if par 1M ints", [&]() { bench::doNotOptimize(algo::find_if(algo::par, algoInput.begin(), algoInput.end(), isNegative)); }, algoOpts);
+	suite.add("algo std::count_if 1M ints", [&]() { bench::doNotOptimize(std::count_if(algoInput.begin(), algoInput.end(), isOdd)); }, algoOpts);
+	suite.add("algo algo::count_if par_unseq 1M ints", [&]() { bench::doNotOptimize(algo::count_if(algo::par_unseq, algoInput.begin(), algoInput.end(), isOdd)); }, algoOpts);
+	suite.add("algo std::merge 1M + 512K", [&]() { std::merge(algoSorted.begin(), algoSorted.end(), algoOther.begin(), algoOther.end(), algoOut.begin()); }, algoOpts);
+	suite.add("algo algo::merge par 1M + 512K", [&]() { algo::merge(algo::par, algoSorted.begin(), algoSorted.end(), algoOther.begin(), algoOther.end(), algoOut.begin()); }, algoOpts);
+	suite.add("algo std::set_union 1M + 512K", [&]() { std::set_union(algoSorted.begin(), algoSorted.end(), algoOther.begin(), algoOther.end(), algoOut.begin()); }, algoOpts);
+	suite.add("algo algo::set_union par 1M + 512K", [&]() { algo::set_union(algo::par, algoSorted.begin(), algoSorted.end(), algoOther.begin(), algoOther.end(), algoOut.begin()); }, algoOpts);
+
+	suite.add("reverse bits computed", [&]() { for (int i = 0; i < arraySize; i++) pBlock[i] = reverseBits(pBlock[i]); bench::doNotOptimize(pBlock); }, { 1, 5, arraySize });
+	suite.add("reverse bits lookup table", [&]() { for (int i = 0; i < arraySize; i++) pBlock[i] = reverseBitsTable[pBlock[i]]; bench::doNotOptimize(pBlock); }, { 1, 5, arraySize });
+
+	// push_back_vec vs emplace_many vs SmallVector (smallvec.h): 10000 small vectors of 8 ints / 4 strings, allocations counted per vector
+	const int vecCount = 10000;
+	size_t allocsPushBack = 0, allocsEmplace = 0, allocsSmall = 0, allocsPushBackStr = 0, allocsEmplaceStr = 0;
+	auto countAllocs = [](size_t &allocs, auto build) {
+		alloccount::Scope scope;
+		for (int i = 0; i < vecCount; i++)
+			build(i);
+		allocs = scope.allocations() / vecCount;
+	};
+	suite.add("vector push_back_vec 8 ints", [&]() { countAllocs(allocsPushBack, [](int i) { vector<int> v; push_back_vec(v, i, 1, 2, 3, 4, 5, 6, 7); bench::doNotOptimize(v.data()); }); });
+	suite.add("vector emplace_many 8 ints", [&]() { countAllocs(allocsEmplace, [](int i) { vector<int> v; emplace_many(v, i, 1, 2, 3, 4, 5, 6, 7); bench::doNotOptimize(v.data()); }); });
+	suite.add("SmallVector<int, 8> emplace_many 8 ints", [&]() { countAllocs(allocsSmall, [](int i) { SmallVector<int, 8> v; emplace_many(v, i, 1, 2, 3, 4, 5, 6, 7); bench::doNotOptimize(v.data()); }); });
+	suite.add("vector push_back_vec 4 temp strings", [&]() {
+		countAllocs(allocsPushBackStr, [](int i) { vector<string> v; push_back_vec(v, string(32, 'a'), string(32, 'b'), string(32, 'c'), to_string(i)); bench::doNotOptimize(v.data()); });
+	});
+	suite.add("vector emplace_many 4 temp strings", [&]() {
+		countAllocs(allocsEmplaceStr, [](int i) { vector<string> v; emplace_many(v, string(32, 'a'), string(32, 'b'), string(32, 'c'), to_string(i)); bench::doNotOptimize(v.data()); });
+	});
+
+	// Callbacks (funcref.h): one lambda called 1M times directly, through std::function, function_ref and inplace_function. Its capture is
+	// 32 bytes, more than the 16 std::function keeps inline, so every std::function made from it allocates (counted per callback made)
+	long long cbSum = 0, cbScale = 3, cbOffset = 1;
+	int cbShift = 2;
+	auto callback = [&cbSum, &cbScale, &cbOffset, cbShift](long long x) { cbSum += (x * cbScale + cbOffset) >> cbShift; };
+	std::function<void (long long)> cbStd = callback;
+	function_ref<void (long long)> cbRef = callback;
+	inplace_function<void (long long)> cbInplace = callback;
+	auto callLoop = [&](auto &cb) {
+		bench::doNotOptimize(cb); // so the compiler can't see which lambda is in there and call it directly
+		for (int i = 0; i < 1000000; i++)
+			cb(i);
+		bench::doNotOptimize(cbSum);
+	};
+	suite.add("callback lambda direct 1M calls", [&]() { callLoop(callback); });
+	suite.add("callback std::function 1M calls", [&]() { callLoop(cbStd); });
+	suite.add("callback function_ref 1M calls", [&]() { callLoop(cbRef); });
+	suite.add("callback inplace_function 1M calls", [&]() { callLoop(cbInplace); });
+	size_t allocsStdFunction = 0, allocsFunctionRef = 0, allocsInplace = 0;
+	suite.add("callback make std::function", [&]() { countAllocs(allocsStdFunction, [&](int i) { std::function<void (long long)> f = callback; f(i); }); });
+	suite.add("callback make function_ref", [&]() { countAllocs(allocsFunctionRef, [&](int i) { function_ref<void (long long)> f = callback; f(i); }); });
+	suite.add("callback make inplace_function", [&]() { countAllocs(allocsInplace, [&](int i) { inplace_function<void (long long)> f = callback; f(i); }); });
+
+	// throw std::string + catch by value (fnoe) vs err::expected, 100K calls at 0, 1, 10 and 50% errors
+	for (int failEvery : { 0, 100, 10, 2 }) {
+		string rate = " " + to_string(failEvery ? 100 / failEvery : 0) + "% errors";
+		suite.add("error throw std::string" + rate, [=]() {
+			long long sum = 0;
+			for (int i = 1; i <= 100000; i++) {
+				try {
+					sum += parseThrowing(i, failEvery);
+				} catch (std::string s) {
+					sum -= s.size();
+				}
+			}
+			bench::doNotOptimize(sum);
+		}, { 1, 5 });
+		suite.add("error err::expected" + rate, [=]() {
+			long long sum = 0;
+			for (int i = 1; i <= 100000; i++) {
+				auto r = parseExpected(i, failEvery);
+				sum += r ? *r : -static_cast<long long>(r.error().message().size());
+			}
+			bench::doNotOptimize(sum);
+		}, { 1, 5 });
+	}
+
+	mutex m;
+
+	string sT = "";
+	auto threadFunc = [&sT,&m](const char c, const int nof) {
+		for (int i = 0; i < nof; i++) {
+			{
+				std::scoped_lock<std::mutex> lock(m); // unlocks after each loop
+				//std::scoped_lock<std::mutex,std::mutex> lock(m,m2); // note that scoped_lock can lock many mutexes in one step, like here 
+				//whereas unique_lock only locks one but has more options
+				sT = sT + c;
+			}
+			Sleep(1);
+		}
+	};
+
+	// The thread demos sleep 200 times per thread, so only a few runs of them
+	bench::Options slowOpts { 0, 3 };
+	auto resetST = [&sT]() { sT = ""; };
+
+	string sThreads;
+	suite.add("threads 2x threadFunc", [&]() {
+		thread t1(threadFunc, 'x', 200);
+		thread t2(threadFunc, 'o', 200);
+
+		t1.join();
+		t2.join();
+		sThreads = sT;
+	}, slowOpts, resetST);
+
+	string sTAsync;
+	suite.add("async 2x threadFunc", [&]() {
+		auto fut1 = async(threadFunc, 'x', 200);
+		auto fut2 = async(threadFunc, 'o', 200);
+
+		fut1.wait();
+		fut2.wait();
+		sTAsync = sT;
+	}, slowOpts, resetST);
+
+	// threadFunc without the mutex (appendbuf.h): each append reserves its own slot with one atomic add, nothing is copied and nobody waits.
+	// Same Sleep(1) per char, so this one is about the output (the interleaving is kept), the throughput cases are below
+	AppendBuffer<char> appendBuf(2 * 200);
+	auto threadFuncLockFree = [&appendBuf](const char c, const int nof) {
+		for (int i = 0; i < nof; i++) {
+			appendBuf.append(c);
+			Sleep(1);
+		}
+	};
+	string sLockFree;
+	suite.add("threads 2x threadFunc lock-free", [&]() {
+		thread t1(threadFuncLockFree, 'x', 200);
+		thread t2(threadFuncLockFree, 'o', 200);
+
+		t1.join();
+		t2.join();
+		sLockFree.assign(appendBuf.begin(), appendBuf.end());
+	}, slowOpts, [&]() { appendBuf.clear(); });
+
+	// threadFunc-style periodic work on a timer wheel (timerwheel.h): one timer thread drives both "threads", 1 ms period, 200 ticks each.
+	// The callbacks all run on the timer thread so the string needs no lock at all
+	TimerWheel wheel;
+	string sWheel;
+	suite.add("timer wheel 2x periodic 1ms x200", [&]() {
+		promise<void> finished;
+		atomic<int> left { 2 };
+		for (char c : { 'x', 'o' }) {
+			wheel.schedulePeriodic(chrono::milliseconds(1), [&, c, n = 0]() mutable {
+				sWheel += c;
+				if (++n < 200)
+					return true;
+				if (--left == 0)
+					finished.set_value();
+				return false;
+			});
+		}
+		finished.get_future().wait();
+	}, slowOpts, [&]() { sWheel = ""; wheel.resetJitter(); });
+
+	// Wake-up jitter: how late each wake-up is vs the deadline, Sleep(1) (nanosleep) vs sleep-then-spin
+	JitterStats sleepJitter, hybridJitter;
+	suite.add("Sleep(1) x200", [&]() {
+		for (int i = 0; i < 200; i++) {
+			auto deadline = chrono::steady_clock::now() + chrono::milliseconds(1);
+			Sleep(1);
+			sleepJitter.add(chrono::duration<double, micro>(chrono::steady_clock::now() - deadline).count());
+		}
+	}, { 0, 1 });
+	suite.add("hybridSleepUntil 1ms x200", [&]() {
+		auto deadline = chrono::steady_clock::now();
+		for (int i = 0; i < 200; i++) {
+			deadline += chrono::milliseconds(1);
+			hybridSleepUntil(deadline);
+			hybridJitter.add(chrono::duration<double, micro>(chrono::steady_clock::now() - deadline).count());
+		}
+	}, { 0, 1 });
+
+	// Append throughput without the sleeps, 2 to 64 threads: the current mutex + sT = sT + c vs the lock-free buffers
+	const int appendsPerThread = 500;
+	auto runThreads = [](int threads, auto body) {
+		vector<thread> ts;
+		for (int t = 0; t < threads; t++)
+			ts.emplace_back(body, t);
+		for (auto &t : ts)
+			t.join();
+	};
+	for (int threads = 2; threads <= 64; threads *= 2) {
+		string name = " " + to_string(threads) + "t";
+		bench::Options appendOpts { 1, 5 };
+		suite.add("append mutex sT = sT + c" + name, [=, &m, &sT]() {
+			runThreads(threads, [&](int t) {
+				for (int i = 0; i < appendsPerThread; i++) {
+					std::scoped_lock<std::mutex> lock(m);
+					sT = sT + char('a' + t % 26);
+				}
+			});
+		}, appendOpts, resetST);
+
+		auto shared = make_shared<AppendBuffer<char>>(threads * appendsPerThread);
+		suite.add("append AppendBuffer" + name, [=]() {
+			runThreads(threads, [&](int t) {
+				for (int i = 0; i < appendsPerThread; i++)
+					shared->append(char('a' + t % 26));
+			});
+		}, appendOpts, [=]() { shared->clear(); });
+
+		for (bool ordered : { false, true }) {
+			auto segmented = make_shared<SegmentedAppender<char>>(threads, ordered, appendsPerThread);
+			suite.add(string("append SegmentedAppender") + (ordered ? " ordered" : "") + name, [=]() {
+				runThreads(threads, [&](int t) {
+					auto w = segmented->writer(t);
+					for (int i = 0; i < appendsPerThread; i++)
+						w.append(char('a' + t % 26));
+				});
+				string merged;
+				segmented->mergeInto(merged);
+				bench::doNotOptimize(merged);
+			}, appendOpts, [=]() { segmented->clear(); });
+		}
+	}
+
+	// The one mutex m vs striped locks (stripedlock.h): 64 keys, each with its own counters, every thread updates keys all over the place.
+	// 1 stripe is the single mutex (the counting costs the same for all, a clock read per contended acquisition)
+	struct alignas(64) KeyData { uint64_t hits = 0, sum = 0; };
+	auto keys = make_shared<array<KeyData, 64>>();
+	vector<pair<string, function<LockStats()>>> lockStats;
+	auto addStriped = [&](auto *lockType, const char *lockName, size_t stripes, int threads) {
+		using Lock = remove_pointer_t<decltype(lockType)>; // only the type, always nullptr
+		auto locks = make_shared<StripedLocks<CountedLock<Lock>>>(stripes);
+		string name = string("striped ") + lockName + " " + to_string(stripes) + "s " + to_string(threads) + "t";
+		suite.add(name, [=]() {
+			runThreads(threads, [&](int t) {
+				for (int i = 0; i < 2000; i++) {
+					size_t key = (i * 31 + t * 7) % keys->size();
+					locks->with(key, [&]() { (*keys)[key].hits++; (*keys)[key].sum += i; });
+				}
+			});
+		}, { 1, 5 });
+		lockStats.emplace_back(name, [locks]() { return locks->stats(); });
+	};
+	for (int threads : { 2, 8, 32 }) {
+		for (size_t stripes : { 1, 4, 16, 64 })
+			addStriped(static_cast<std::mutex *>(nullptr), "std::mutex", stripes, threads);
+		for (size_t stripes : { 1, 16 }) {
+			addStriped(static_cast<SpinLock *>(nullptr), "SpinLock", stripes, threads);
+			addStriped(static_cast<AdaptiveMutex *>(nullptr), "AdaptiveMutex", stripes, threads);
+		}
+	}
+
+	// The allocations of each fut3 variant are counted inside the task, on the thread that builds the string (alloccount.h)
+	size_t allocsNaive = 0, allocsBuilder = 0, allocsArena = 0;
+	string sF;
+	suite.add("async string build", [&]() {
+		auto fut3 = async([&allocsNaive]() { alloccount::Scope scope; string s=""; for (int i = 0; i < 200; i++) s = s + 'A'; allocsNaive = scope.allocations(); return s; } );
+
+		sF = fut3.get();
+	});
+
+	// Same string built in place (strbuilder.h): reserved once, appended to, then moved into the future and out of it again, no copies
+	string sFBuilder;
+	suite.add("async string build StringBuilder", [&]() {
+		auto fut3 = async([&allocsBuilder]() {
+			alloccount::Scope scope;
+			StringBuilder sb(200);
+			for (int i = 0; i < 200; i++)
+				sb += 'A';
+			allocsBuilder = scope.allocations();
+			return std::move(sb).str();
+		});
+
+		sFBuilder = fut3.get();
+	});
+	// And from an arena: after the first run has allocated the arena's block, building the string doesn't touch the heap at all
+	Arena stringArena;
+	ArenaString sFArena { ArenaAllocator<char>(stringArena) };
+	suite.add("async string build ArenaStringBuilder", [&]() {
+		auto fut3 = async([&]() {
+			alloccount::Scope scope;
+			ArenaStringBuilder sb(200, stringArena);
+			for (int i = 0; i < 200; i++)
+				sb += 'A';
+			allocsArena = scope.allocations();
+			return std::move(sb).str();
+		});
+
+		sFArena = fut3.get();
+	}, {}, [&]() {
+		ArenaString(ArenaAllocator<char>(stringArena)).swap(sFArena); // sFArena's old buffer is in the arena, so let go of it first (clear() keeps it)
+		stringArena.reset();
+	});
+
+	// The same fut1/fut2/fut3 pattern on a work-stealing executor (executor.h): a fixed set of workers instead of a thread per async (or none, if deferred)
+	WorkStealingExecutor executor;
+	string sTExec, sFExec;
+	suite.add("executor 2x threadFunc", [&]() {
+		auto task1 = executor.submit([&]() { threadFunc('x', 200); });
+		auto task2 = executor.submit([&]() { threadFunc('o', 200); });
+
+		task1.wait();
+		task2.wait();
+		sTExec = sT;
+	}, slowOpts, resetST);
+	suite.add("executor string build + then", [&]() {
+		auto task3 = executor.submit([]() { string s=""; for (int i = 0; i < 200; i++) s = s + 'A'; return s; } )
+			.then([](string s) { return s + " (" + to_string(s.size()) + " chars)"; }); // continuation runs on a worker as soon as the string is done
+
+		sFExec = task3.get();
+	});
+
+#if !defined(USING_WIN_32)
+	// FoldPrint (iostreams) vs out::print (printbuf.h), 10000 lines each. stdout is pointed at /dev/null while they run, so this is the
+	// cost of formatting and of the calls that hand the bytes to the kernel, not of the terminal
+	const int printLines = 10000;
+	int savedStdout = -1;
+	auto stdoutToNull = [&]() {
+		fflush(stdout);
+		savedStdout = dup(1);
+		int devNull = open("/dev/null", O_WRONLY);
+		dup2(devNull, 1);
+		close(devNull);
+	};
+	auto stdoutBack = [&]() {
+		cout.flush();
+		out::flush();
+		fflush(stdout);
+		dup2(savedStdout, 1);
+		close(savedStdout);
+	};
+	bench::Options printOpts { 1, 5 };
+	suite.add("print FoldPrint cout x10000", [&]() { for (int i = 0; i < printLines; i++) FoldPrint("Hello ", "Mr ", i, '!', " ", 0.5 * i); }, printOpts, stdoutToNull, stdoutBack);
+	suite.add("print out::print line x10000", [&]() { for (int i = 0; i < printLines; i++) out::print("Hello ", "Mr ", i, '!', " ", 0.5 * i); }, printOpts, stdoutToNull, stdoutBack);
+	suite.add("print out::print batch x10000", [&]() {
+		out::local().setMode(out::Mode::Batch);
+		for (int i = 0; i < printLines; i++)
+			out::print("Hello ", "Mr ", i, '!', " ", 0.5 * i);
+		out::local().setMode(out::Mode::Line); // flushes
+	}, printOpts, stdoutToNull, stdoutBack);
+	// From 4 threads at once. cout can mix pieces of lines from different threads, out::print can't
+	suite.add("print FoldPrint cout 4t x2500", [&]() {
+		runThreads(4, [&](int t) { for (int i = 0; i < printLines / 4; i++) FoldPrint("Hello ", "Mr ", t, '!', " ", 0.5 * i); });
+	}, printOpts, stdoutToNull, stdoutBack);
+	suite.add("print out::print batch 4t x2500", [&]() {
+		runThreads(4, [&](int t) {
+			out::local().setMode(out::Mode::Batch); // each thread's buffer is written out when it is full, and when the thread ends
+			for (int i = 0; i < printLines / 4; i++)
+				out::print("Hello ", "Mr ", t, '!', " ", 0.5 * i);
+		});
+	}, printOpts, stdoutToNull, stdoutBack);
+#endif
+
+	// Spawn latency: 1000 x start an empty task and wait for it
+	suite.add("spawn 1000x std::async default", [&]() { for (int i = 0; i < 1000; i++) async([]() { return 1; }).get(); }, { 1, 5 });
+	suite.add("spawn 1000x std::async launch::async", [&]() { for (int i = 0; i < 1000; i++) async(launch::async, []() { return 1; }).get(); }, { 1, 5 });
+	suite.add("spawn 1000x executor submit", [&]() { for (int i = 0; i < 1000; i++) executor.submit([]() { return 1; }).get(); }, { 1, 5 });
+	suite.add("spawn 1000x executor submit, get all", [&]() {
+		vector<Task<int>> tasks;
+		for (int i = 0; i < 1000; i++)
+			tasks.push_back(executor.submit([]() { return 1; }));
+		for (auto &t : tasks)
+			t.get();
+	}, { 1, 5 });
+
+	suite.run();
+
+	if (!csvFile.empty()) {
+		ofstream csv(csvFile);
+		suite.writeCsv(csv);
+	}
+	if (!jsonFile.empty()) {
+		ofstream json(jsonFile);
+		suite.writeJson(json);
+	}
+
+	if (filesystem::exists(framePath)) {
+		MappedFile frame(framePath); // read back what the last output case wrote
+		bool ok = frame.size() == size_t(arraySize);
+		for (size_t i = 0; ok && i < frame.size(); i++)
+			ok = frame.data()[i] == static_cast<unsigned char>(i);
+		cout << "output file " << framePath << (ok ? " verified" : " has WRONG contents") << "\n";
+		frame.close();
+		filesystem::remove(framePath);
+	}
+	if (filesystem::exists(pipelinePath)) {
+		MappedFile frame(pipelinePath);
+		bool ok = frame.size() == size_t(arraySize);
+		for (size_t i = 0; ok && i < frame.size(); i++)
+			ok = frame.data()[i] == reverseBitsTable[i % 256];
+		cout << "pipeline output " << (ok ? "verified" : "has WRONG contents") << ", resident size grew by (MB):";
+		const char *sep = " ";
+		for (auto &[name, peak] : pipelinePeaks) {
+			if (!peak)
+				continue;
+			cout << sep << name << " " << *peak / (1024.0 * 1024.0);
+			sep = ", ";
+		}
+		cout << "\n";
+#if !defined(CORO_AVAILABLE)
+		cout << "pipeline: the streamed versions need coroutines, build with -std=c++20\n";
+#endif
+		frame.close();
+		filesystem::remove(pipelinePath);
+	}
+	cout << "buf:: fill kernels in use: " << buf::isaName(buf::kernels().isa) << ", streaming stores from " << buf::streamingThreshold / 1024 << " KB\n";
+	cout << res << "\n";
+#if defined(FIB_HAS_U128)
+	cout << "F(186) = " << u128ToString(fibChecked<fib_u128>(186)) << " (largest that fits in 128 bits)\n";
+#endif
+	try {
+		cout << fibChecked(100) << "\n";
+	} catch (const std::overflow_error &e) { cout << "Caught: " << e.what() << "\n"; }
+	cout << "F(1000) = " << fibBig(1000).toString() << "\n";
 	for (auto x : arr)
         std::cout << x << '\n';
+	static_assert(fibTable[3] == fibFast(40) && reverseBitsTable[0x01] == 0x80, "tables are checked at compile time too");
+	static_assert(fibCEMemo(40) == fibFast(40) && fibRecurrenceTable[93] == fibFast(93), "memoized versions agree");
 
 	cout << sum(45, 66, 88, 109) << "\n";
+	static_assert(fold::of(fold::Max {}, 45, 66, 88, 109) == 109 && fold::of(fold::BitXor {}, 1, 2, 4) == 7, "same folds, any operator");
+	if (floatLoop != 0 && floatLanes != 0 && floatKahan != 0 && floatPairwise != 0) // all four ran
+		cout << "float sum relative error: loop " << (floatLoop - floatRef) / floatRef << ", lanes " << (floatLanes - floatRef) / floatRef << ", Kahan "
+			<< (floatKahan - floatRef) / floatRef << ", pairwise " << (floatPairwise - floatRef) / floatRef << "\n";
 
 	FoldPrint("Hello ", "Mr ", 242, '!');
+	out::print("Hello ", "Mr ", 242, '!'); // same output, no iostreams
+	if (allocsPushBack + allocsEmplace + allocsPushBackStr > 0)
+		cout << "heap allocations per vector: push_back_vec " << allocsPushBack << ", emplace_many " << allocsEmplace << ", SmallVector " << allocsSmall
+			<< " (4 temp strings: push_back_vec " << allocsPushBackStr << ", emplace_many " << allocsEmplaceStr << ")\n";
+	if (cbSum != 0)
+		cout << "heap allocations per callback made: std::function " << allocsStdFunction << ", function_ref " << allocsFunctionRef << ", inplace_function " << allocsInplace << "\n";
 
 	if (0 and 5) { // and, bitor, or, xor, compl, bitand, and_eq, or_eq, xor_eq, not, and not_eq provide an alternative way to represent standard tokens
 		cout << "Ain't appenin'\n";
@@ -220,6 +1178,7 @@ int main ()
 
 	auto f = [](int a) { return 66; };
 	decltype(f) g = f; // g kommer här bli typ en std::function<int (int)>
+	// (it doesn't, it's the lambda's own type. To store different lambdas in one type without std::function: inplace_function<int (int)> h = f; see funcref.h)
 	int n = 88;
 
 	//cout << "n has type " << typeid(n).name() << '\n'; // ummm.. NOT what I expected, the names are all mangled: n has type i     g has type Z4mainEUliE4_   . Supposedly boost (core/demangle.hpp) can be used to "demangle"
@@ -231,49 +1190,50 @@ int main ()
 	foo foooo = make_foo(); // shows use of explicit
 
 	fnoe();
+	if (auto r = fnoeExpected(); !r)
+		cout << "Returned: " << r.error().message() << "\n";
+	// Steps that can fail, chained: each gets the previous value, the first error skips the rest (84 -> 42 -> 21 -> odd)
+	auto halve = [](int v) -> err::expected<int> {
+		if (v % 2)
+			return err::fail(err::Errc::InvalidArgument, "can't halve " + to_string(v));
+		return v / 2;
+	};
+	auto halved = err::chain(err::expected<int>(84), halve, halve, halve);
+	cout << "84 halved 3 times: " << (halved ? to_string(*halved) : string(err::errcName(halved.error().code())) + ", " + string(halved.error().message())) << "\n";
 	cout << "Hehe...\n";
 
-	const int arraySize = 1920 * 1080 * 10;
-
-	// Note: Interesting, using no -O option, memset is CLEARLY the fastest! But using -O3, all four solutions are typically very similar in speed (fastest one varies)! Wouuld be interesting to try execution::par
-	{
-		auto unique_block = make_unique<unsigned char []>(arraySize);
-		unsigned char *pBlock = unique_block.get();
-		timerFunc([&]() { std::fill(pBlock, pBlock + arraySize, 0x77); }, printTimer);
-	}
-	{
-		auto unique_block = make_unique<unsigned char []>(arraySize);
-		unsigned char *pBlock = unique_block.get();
-		timerFunc([&]() { memset(pBlock, 0x77, arraySize * sizeof(unsigned char)); }, printTimer);
-	}
-	{
-		auto unique_block = make_unique<unsigned char []>(arraySize);
-		unsigned char *pBlock = unique_block.get();
-		timerFunc([&]() { for (int i = 0; i < arraySize; i++) *pBlock++ = 0x77; }, printTimer);
-	}
-	{
-		auto unique_block = vector<unsigned char>(arraySize);
-		timerFunc([&]() { std::fill(unique_block.begin(), unique_block.end(), 0x77); }, printTimer); // time-wise, pretty much the same
-	}
-
-
-	{
-		auto unique_block = make_unique<unsigned char []>(arraySize);
-		unsigned char *pBlock = unique_block.get();
-		int i = 0;
-		timerFunc([&]() { std::generate(pBlock, pBlock + arraySize, [&i]() { return (i++) % 256; } ); }, printTimer);
+	cout << sThreads << "\n";
+	cout << sTAsync << "\n";
+	cout << sTExec << "\n";
+	cout << sLockFree << "\n";
+	cout << sWheel << "\n";
+	auto printJitter = [](const char *what, const JitterStats &j) {
+		if (j.count())
+			cout << what << " late by (us): mean " << j.mean() << ", p50 " << j.percentile(50) << ", p99 " << j.percentile(99) << ", max " << j.max() << "\n";
+	};
+	printJitter("Sleep(1)", sleepJitter);
+	printJitter("hybridSleepUntil", hybridJitter);
+	printJitter("timer wheel", wheel.jitter());
+	cout << "AppendBuffer: blocks appended past capacity " << (checkAppendBufferOverflow(200) ? "never leave unwritten slots" : "left UNWRITTEN slots") << "\n";
+	const int algoRounds = 40;
+	vector<string> algoFailed = checkParallelAlgorithms(algoRounds);
+	if (algoFailed.empty()) {
+		cout << "algo:: matches std on " << algoRounds << " random inputs\n";
+	} else {
+		cout << "algo:: DIFFERS from std:";
+		for (auto &name : algoFailed)
+			cout << " " << name;
+		cout << "\n";
 	}
-	{
-		auto unique_block = make_unique<unsigned char []>(arraySize);
-		unsigned char *pBlock = unique_block.get();
-		timerFunc([&]() { for (int i = 0; i < arraySize; i++) *pBlock++ = i % 256;; }, printTimer);
+	for (auto &[name, stats] : lockStats) {
+		LockStats st = stats();
+		if (st.acquisitions)
+			cout << name << ": " << 100 * st.contendedShare() << "% of acquisitions waited, " << st.meanWaitNs() / 1000 << " us per wait\n";
 	}
-	{
-		auto unique_block = vector<unsigned char>(arraySize);
-		int i = 0;
-		timerFunc([&]() { std::generate(unique_block.begin(), unique_block.end(), [&i]() { return (i++) % 256; } ); }, printTimer); // time-wise, pretty much the same
-	}
-
+	cout << sF << "\n";
+	cout << sFExec << "\n";
+	if (!sF.empty() && sFBuilder == sF && string(sFArena.begin(), sFArena.end()) == sF)
+		cout << "fut3 heap allocations per build: s = s + 'A' " << allocsNaive << ", StringBuilder " << allocsBuilder << ", ArenaStringBuilder " << allocsArena << "\n";
 
 	// algorithm std functions:
 
@@ -306,49 +1266,12 @@ int main ()
 
 	// #pragma once    : C++ way of #ifndef ME_H #define ME_H etc...
 
-	mutex m;
-
-	string sT = "";
-	auto threadFunc = [&sT,&m](const char c, const int nof) {
-		for (int i = 0; i < nof; i++) {
-			{
-				std::scoped_lock<std::mutex> lock(m); // unlocks after each loop
-				//std::scoped_lock<std::mutex,std::mutex> lock(m,m2); // note that scoped_lock can lock many mutexes in one step, like here 
-				//whereas unique_lock only locks one but has more options
-				sT = sT + c;
-			}
-			Sleep(1);
-		}
-	};
-
-	thread t1(threadFunc, 'x', 200);
-	thread t2(threadFunc, 'o', 200);
-
-	t1.join();
-	t2.join();
-
-	cout << sT << "\n";
-
-	sT = "";
-	auto fut1 = async(threadFunc, 'x', 200);
-	auto fut2 = async(threadFunc, 'o', 200);
-
-	fut1.wait();
-	fut2.wait();
-
-	cout << sT << "\n";
-
-	auto fut3 = async([]() { string s=""; for (int i = 0; i < 200; i++) s = s + 'A'; return s; } );
-
-	auto sF = fut3.get();
-	cout << sF << "\n";
-
-
 	// Parallell execution algorithm (g++ 10+)
 	/*
 	std::array<int, 4> arr2 = { 55,66,77,88 };
 	bool algores = std::all_of(std::execution::par, arr2.begin(), arr2.end(), [](int i) { return i < 666; }); // std::execution::par (<execution> header) means parallell execution of this algo. Note, we must ensure it is thred-safe ourselves!   So DONT go adding to a vector or access shared mem without mutex in par execution.
 	*/
+	// Without <execution>: algo::all_of(algo::par, arr2.begin(), arr2.end(), ...) from palgo.h, on the ThreadPool (also sort, merge, scans, find, set ops)
 
 
 	// C++ Patterns: the rule of 5
@@ -0,0 +1,362 @@
+#pragma once
+
+// C++20 coroutines for streaming a buffer through stages a chunk at a time, instead of generating the whole 20 MB block before anyone looks at it.
+//
+//	coro::generator<Chunk> chunks(size_t total)						// lazy: runs up to the next co_yield each time the consumer asks
+//	{
+//		vector<unsigned char> b(64 * 1024);
+//		for (size_t done = 0; done < total; done += b.size()) {
+//			fill(b);
+//			co_yield Chunk { b.data(), b.size() };					// b is reused, so the consumer is done with a chunk before the next one is made
+//		}
+//	}
+//	for (Chunk c : chunks(n)) use(c);
+//
+//	coro::task<void> write(ofstream &f, Chunk c, WorkStealingExecutor &ex)
+//	{
+//		co_await coro::resumeOn(ex);								// the rest runs on a worker
+//		f.write(...);
+//	}
+//	auto t = write(f, c, ex);
+//	t.start();														// ... while this thread goes on with the next chunk
+//	co_await t;														// (in another task) or coro::sync_wait(t) (in normal code)
+//
+// generator<T>		input range (begin()/end(), range for), values come from co_yield. Exceptions from the body come out of begin()/++
+// task<T>			lazy: doesn't run until co_await'ed or start()ed. co_await on a task gives its co_return value (or rethrows), the
+//					awaiting coroutine continues on whichever thread the task finished on. A started task has to be awaited or sync_wait'ed
+//					before it's destroyed
+// sync_wait(t)		blocks a normal function until t is done, returns its value
+// resumeOn(ex)		co_await it to move the coroutine onto a WorkStealingExecutor worker (executor.h)
+//
+// All of it only with coroutine support (-std=c++20, or /std:c++latest): CORO_AVAILABLE is defined then, and this header is empty otherwise.
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#define CORO_AVAILABLE
+#endif
+#endif
+
+#if defined(CORO_AVAILABLE)
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "executor.h"	// WorkStealingExecutor, for resumeOn
+
+namespace coro {
+
+template <typename T>
+class generator {
+public:
+	using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+	using reference = std::conditional_t<std::is_reference_v<T>, T, T &>;
+
+	struct promise_type {
+		std::remove_reference_t<T> *current = nullptr;	// the co_yield'ed object, it lives in the suspended body until the next resume
+		std::exception_ptr error;
+
+		generator get_return_object() { return generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		std::suspend_always yield_value(std::remove_reference_t<T> &v) noexcept
+		{
+			current = std::addressof(v);
+			return {};
+		}
+		std::suspend_always yield_value(std::remove_reference_t<T> &&v) noexcept
+		{
+			current = std::addressof(v);
+			return {};
+		}
+		void return_void() {}
+		void unhandled_exception() { error = std::current_exception(); }
+
+		template <typename U>
+		std::suspend_never await_transform(U &&) = delete;	// a generator only yields, there is nobody to resume it after a co_await
+	};
+
+	class iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = generator::value_type;
+		using reference = generator::reference;
+
+		iterator() = default;
+		explicit iterator(std::coroutine_handle<promise_type> h) : h(h) {}
+
+		reference operator*() const { return static_cast<reference>(*h.promise().current); }
+		auto operator->() const { return h.promise().current; }
+
+		iterator &operator++()
+		{
+			h.resume();
+			rethrow(h);
+			return *this;
+		}
+		void operator++(int) { ++*this; }
+
+		bool operator==(std::default_sentinel_t) const { return !h || h.done(); }
+
+	private:
+		std::coroutine_handle<promise_type> h;
+	};
+
+	generator(generator &&other) noexcept : h(std::exchange(other.h, nullptr)) {}
+	generator &operator=(generator &&other) noexcept
+	{
+		std::swap(h, other.h);
+		return *this;
+	}
+	~generator()
+	{
+		if (h)
+			h.destroy();
+	}
+
+	// Runs the body up to the first co_yield, so only call it once
+	iterator begin()
+	{
+		if (h) {
+			h.resume();
+			rethrow(h);
+		}
+		return iterator(h);
+	}
+	std::default_sentinel_t end() const { return {}; }
+
+private:
+	explicit generator(std::coroutine_handle<promise_type> h) : h(h) {}
+
+	static void rethrow(std::coroutine_handle<promise_type> h)
+	{
+		if (h.done() && h.promise().error)
+			std::rethrow_exception(h.promise().error);
+	}
+
+	std::coroutine_handle<promise_type> h;
+};
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+// waiter: nullptr while running with nobody waiting, the awaiting coroutine's address once someone waits, doneMarker() once finished.
+// Whoever comes second (the finishing task or the awaiter) resumes the awaiter, so a task started on another thread can finish before or after the co_await
+inline void *doneMarker()
+{
+	static char marker;
+	return &marker;
+}
+
+struct TaskPromiseBase {
+	std::atomic<void *> waiter { nullptr };
+	std::exception_ptr error;
+
+	struct FinalAwaiter {
+		bool await_ready() noexcept { return false; }
+		template <typename P>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+		{
+			void *w = h.promise().waiter.exchange(doneMarker(), std::memory_order_acq_rel);
+			return w ? std::coroutine_handle<>::from_address(w) : std::noop_coroutine(); // straight into the awaiter, no extra stack frame
+		}
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+	FinalAwaiter final_suspend() noexcept { return {}; }
+	void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+	std::optional<T> value;
+
+	task<T> get_return_object();
+	template <typename U>
+	void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+
+	T result()
+	{
+		if (error)
+			std::rethrow_exception(error);
+		return std::move(*value);
+	}
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+	task<void> get_return_object();
+	void return_void() {}
+
+	void result()
+	{
+		if (error)
+			std::rethrow_exception(error);
+	}
+};
+
+} // namespace detail
+
+template <typename T>
+class task {
+public:
+	using promise_type = detail::TaskPromise<T>;
+
+	task() = default;
+	task(task &&other) noexcept : h(std::exchange(other.h, nullptr)), started(other.started) {}
+	task &operator=(task &&other) noexcept
+	{
+		std::swap(h, other.h);
+		std::swap(started, other.started);
+		return *this;
+	}
+	~task()
+	{
+		if (h)
+			h.destroy();
+	}
+
+	explicit operator bool() const { return h != nullptr; }
+	bool done() const { return h && h.promise().waiter.load(std::memory_order_acquire) == detail::doneMarker(); }
+
+	// Runs the body on this thread up to its first suspension (a resumeOn moves it to a worker), without waiting for the result
+	void start()
+	{
+		if (h && !started) {
+			started = true;
+			h.resume();
+		}
+	}
+
+	// Only waits, the result is left in the task (sync_wait's helper uses it, its own exceptions would have nowhere to go)
+	struct ReadyAwaiter {
+		task *t;
+
+		bool await_ready() const { return t->done(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+		{
+			if (!t->started) {
+				t->started = true;
+				t->h.promise().waiter.store(awaiting.address(), std::memory_order_release);
+				return t->h; // start it, it resumes us when it's done
+			}
+			void *expected = nullptr;
+			if (t->h.promise().waiter.compare_exchange_strong(expected, awaiting.address(), std::memory_order_acq_rel))
+				return std::noop_coroutine();
+			return awaiting; // finished in the meantime
+		}
+		void await_resume() const {}
+	};
+
+	struct Awaiter : ReadyAwaiter {
+		T await_resume() const { return this->t->h.promise().result(); }
+	};
+
+	Awaiter operator co_await() & { return Awaiter { { this } }; }
+	Awaiter operator co_await() && { return Awaiter { { this } }; }
+	ReadyAwaiter whenReady() { return ReadyAwaiter { this }; }
+
+private:
+	friend struct detail::TaskPromise<T>;
+	template <typename U> friend U sync_wait(task<U> &t);
+
+	explicit task(std::coroutine_handle<promise_type> h) : h(h) {}
+
+	std::coroutine_handle<promise_type> h;
+	bool started = false;
+};
+
+namespace detail {
+
+template <typename T>
+task<T> TaskPromise<T>::get_return_object() { return task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this)); }
+inline task<void> TaskPromise<void>::get_return_object() { return task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this)); }
+
+struct Latch {
+	std::mutex m;
+	std::condition_variable cv;
+	bool set = false;
+
+	void arrive()
+	{
+		std::scoped_lock<std::mutex> lock(m); // notify while holding it, the waiter destroys the latch as soon as it sees set
+		set = true;
+		cv.notify_all();
+	}
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		cv.wait(lock, [this]() { return set; });
+	}
+};
+
+// A coroutine that awaits a task and then opens the latch, from its final suspend point: once the latch is open it's suspended for good and can be destroyed
+struct SyncWaiter {
+	struct promise_type {
+		Latch *latch = nullptr;
+
+		struct Arrive {
+			bool await_ready() noexcept { return false; }
+			void await_suspend(std::coroutine_handle<promise_type> h) noexcept { h.promise().latch->arrive(); }
+			void await_resume() noexcept {}
+		};
+
+		SyncWaiter get_return_object() { return SyncWaiter { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		Arrive final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); } // only ever awaits a ReadyAwaiter, which doesn't throw
+	};
+
+	std::coroutine_handle<promise_type> h;
+};
+
+template <typename T>
+SyncWaiter waitFor(task<T> &t)
+{
+	co_await t.whenReady();
+}
+
+} // namespace detail
+
+template <typename T>
+T sync_wait(task<T> &t)
+{
+	detail::Latch latch;
+	auto waiter = detail::waitFor(t);
+	waiter.h.promise().latch = &latch;
+	waiter.h.resume();
+	latch.wait();
+	waiter.h.destroy();
+	return t.h.promise().result();
+}
+
+template <typename T>
+T sync_wait(task<T> &&t) { return sync_wait(t); }
+
+// co_await resumeOn(ex): the coroutine continues as a job on one of ex's workers
+struct resumeOn {
+	explicit resumeOn(WorkStealingExecutor &ex) : ex(ex) {}
+
+	bool await_ready() const { return false; }
+	void await_suspend(std::coroutine_handle<> h) const { ex.post([h]() { h.resume(); }); }
+	void await_resume() const {}
+
+	WorkStealingExecutor &ex;
+};
+
+} // namespace coro
+
+#endif // CORO_AVAILABLE
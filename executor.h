@@ -0,0 +1,297 @@
+#pragma once
+
+// Work-stealing task executor, an alternative to std::async for the fut1/fut2/fut3 pattern in main().
+// std::async with the default policy may start a new OS thread per call or defer the work until get(), so latency is anyone's guess.
+// Here a fixed set of workers runs everything:
+//
+//	WorkStealingExecutor ex;
+//	auto t = ex.submit([] { return string("A"); });
+//	auto t2 = t.then([](string s) { return s + "!"; });	// continuation, runs on a worker when t is done
+//	cout << t2.get();
+//
+// Every worker has its own deque: tasks submitted from a worker go to the back of its own deque and it takes from the back (LIFO, the data is
+// still in its cache), idle workers steal from the front of the others (the oldest, usually biggest, pieces of work). Tasks submitted from
+// outside are spread round robin. Each deque has its own small lock, so workers only ever contend with a thief, never all with each other.
+// get()/wait() on a worker thread runs other tasks while waiting, so tasks waiting for tasks don't deadlock the pool.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+class WorkStealingExecutor;
+
+namespace detail {
+
+// Shared state between a running task and its Task<T> handles (what std::promise/std::future share)
+template <typename T>
+struct TaskState {
+	using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+	std::mutex m;
+	std::condition_variable cv;
+	bool done = false;
+	std::optional<Stored> value;
+	std::exception_ptr error;
+	std::vector<std::function<void()>> continuations;
+
+	template <typename F>
+	void run(F &f)
+	{
+		try {
+			if constexpr (std::is_void_v<T>) {
+				f();
+				value.emplace();
+			} else {
+				value.emplace(f());
+			}
+		} catch (...) {
+			error = std::current_exception();
+		}
+		finish();
+	}
+
+	void fail(std::exception_ptr e)
+	{
+		error = e;
+		finish();
+	}
+
+	void finish()
+	{
+		std::vector<std::function<void()>> ready;
+		{
+			std::scoped_lock<std::mutex> lock(m);
+			done = true;
+			ready.swap(continuations);
+		}
+		cv.notify_all();
+		for (auto &c : ready)
+			c();
+	}
+
+	// Runs c right away if the task is already done
+	void onDone(std::function<void()> c)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m);
+			if (!done) {
+				continuations.push_back(std::move(c));
+				return;
+			}
+		}
+		c();
+	}
+
+	bool isDone()
+	{
+		std::scoped_lock<std::mutex> lock(m);
+		return done;
+	}
+};
+
+} // namespace detail
+
+template <typename T>
+class Task;
+
+class WorkStealingExecutor {
+public:
+	// At least 2, so two tasks that block (like threadFunc with its Sleep) still run side by side on a single core machine
+	explicit WorkStealingExecutor(unsigned workers = std::max(2u, std::thread::hardware_concurrency())) : queues(workers)
+	{
+		for (unsigned i = 0; i < workers; i++)
+			threads.emplace_back([this, i]() { workerLoop(i); });
+	}
+
+	// Runs what is still queued, then stops
+	~WorkStealingExecutor()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(idleMutex);
+			stopping = true;
+		}
+		idleCv.notify_all();
+		for (auto &t : threads)
+			t.join();
+	}
+
+	WorkStealingExecutor(const WorkStealingExecutor &) = delete;
+	WorkStealingExecutor &operator=(const WorkStealingExecutor &) = delete;
+
+	unsigned workers() const { return static_cast<unsigned>(threads.size()); }
+
+	template <typename F>
+	auto submit(F f) -> Task<std::invoke_result_t<F>>;
+
+	// Raw job, no result handle
+	void post(std::function<void()> job)
+	{
+		size_t q = (currentExecutor == this) ? currentWorker : nextQueue++ % queues.size();
+		pending++; // before the push, so it never goes below the real number of queued jobs
+		{
+			std::scoped_lock<std::mutex> lock(queues[q].m);
+			queues[q].jobs.push_back(std::move(job));
+		}
+		if (sleepers.load() > 0) {
+			std::scoped_lock<std::mutex> lock(idleMutex); // see workerLoop, this can't slip in between its check and its wait
+			idleCv.notify_one();
+		}
+	}
+
+	bool onWorkerThread() const { return currentExecutor == this; }
+
+	// Runs one queued job on the calling thread if there is one (own deque first when called from a worker). Used by Task::wait on workers.
+	bool runOne()
+	{
+		std::function<void()> job;
+		if (!take(onWorkerThread() ? currentWorker : 0, job))
+			return false;
+		job();
+		return true;
+	}
+
+private:
+	struct alignas(64) Queue {
+		std::mutex m;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	// Own deque from the back, then steal from the front of the others
+	bool take(size_t self, std::function<void()> &job)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(queues[self].m);
+			if (!queues[self].jobs.empty()) {
+				job = std::move(queues[self].jobs.back());
+				queues[self].jobs.pop_back();
+				pending--;
+				return true;
+			}
+		}
+		for (size_t i = 1; i < queues.size(); i++) {
+			auto &victim = queues[(self + i) % queues.size()];
+			std::scoped_lock<std::mutex> lock(victim.m);
+			if (!victim.jobs.empty()) {
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				pending--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void workerLoop(unsigned index)
+	{
+		currentExecutor = this;
+		currentWorker = index;
+		std::function<void()> job;
+		for (;;) {
+			if (take(index, job)) {
+				job();
+				job = nullptr;
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(idleMutex);
+			sleepers++;
+			idleCv.wait(lock, [this]() { return pending.load() > 0 || stopping; });
+			sleepers--;
+			if (stopping && pending.load() == 0)
+				return;
+		}
+	}
+
+	std::vector<Queue> queues;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> nextQueue { 0 }, pending { 0 };
+	std::atomic<int> sleepers { 0 };
+	std::mutex idleMutex;
+	std::condition_variable idleCv;
+	bool stopping = false;
+
+	static inline thread_local WorkStealingExecutor *currentExecutor = nullptr;
+	static inline thread_local size_t currentWorker = 0;
+};
+
+// Future-like handle for a submitted task. Unlike std::future it can be copied, and get() can be called more than once (it returns a copy of the value)
+template <typename T>
+class Task {
+public:
+	Task() = default;
+
+	bool valid() const { return state != nullptr; }
+	bool ready() const { return state->isDone(); }
+
+	void wait() const
+	{
+		if (exec->onWorkerThread()) {
+			while (!ready()) // help out instead of blocking a worker
+				if (!exec->runOne())
+					std::this_thread::yield();
+			return;
+		}
+		std::unique_lock<std::mutex> lock(state->m);
+		state->cv.wait(lock, [this]() { return state->done; });
+	}
+
+	// Rethrows the task's exception, if it threw one
+	T get() const
+	{
+		wait();
+		if (state->error)
+			std::rethrow_exception(state->error);
+		if constexpr (!std::is_void_v<T>)
+			return *state->value;
+	}
+
+	// f(value) (or f() for Task<void>) runs on a worker once this task is done. If this task threw, f is skipped and the exception is passed on.
+	template <typename F>
+	auto then(F f)
+	{
+		using R = typename std::conditional_t<std::is_void_v<T>, std::invoke_result<F>, std::invoke_result<F, T>>::type;
+		auto next = std::make_shared<detail::TaskState<R>>();
+		auto prev = state;
+		auto *ex = exec;
+		prev->onDone([prev, next, ex, f = std::move(f)]() {
+			ex->post([prev, next, f]() mutable {
+				if (prev->error)
+					return next->fail(prev->error);
+				auto call = [&]() -> R {
+					if constexpr (std::is_void_v<T>)
+						return f();
+					else
+						return f(*prev->value);
+				};
+				next->run(call);
+			});
+		});
+		return Task<R>(next, ex);
+	}
+
+private:
+	friend class WorkStealingExecutor;
+	template <typename U> friend class Task;
+	Task(std::shared_ptr<detail::TaskState<T>> state, WorkStealingExecutor *exec) : state(std::move(state)), exec(exec) {}
+
+	std::shared_ptr<detail::TaskState<T>> state;
+	WorkStealingExecutor *exec = nullptr;
+};
+
+template <typename F>
+auto WorkStealingExecutor::submit(F f) -> Task<std::invoke_result_t<F>>
+{
+	using R = std::invoke_result_t<F>;
+	auto state = std::make_shared<detail::TaskState<R>>();
+	post([state, f = std::move(f)]() mutable { state->run(f); });
+	return Task<R>(state, this);
+}
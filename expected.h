@@ -0,0 +1,387 @@
+#pragma once
+
+// Errors as return values instead of exceptions, for the fnoe() pattern in main (throw std::string, catch by value: an exception object
+// allocated on the heap, a string copy for the catch by value, and the whole unwinder for every single error).
+//
+//	err::expected<int> parse(string_view s)
+//	{
+//		if (s.empty())
+//			return err::fail(err::Errc::InvalidArgument, "empty");	// no allocation, err::Error is 32 bytes with the message inside
+//		return 42;
+//	}
+//	if (auto r = parse(s)) use(*r); else cout << r.error().message();
+//
+//	parse(s).and_then(check).transform([](int v) { return v * 2; });	// skips the rest at the first error
+//	err::chain(parse(s), check, store);									// same as parse(s) | check | store, a fold over the steps
+//	auto both = err::collect(parse(a), parse(b));						// expected<tuple<int, int>>, or the first error
+//
+// expected<T, E> is a subset of C++23 std::expected (same names: has_value, value, error, value_or, and_then, transform, or_else,
+// transform_error, unexpected). value() on an error throws err::bad_expected_access, for the places that do want an exception.
+// The success path costs a bool next to the value and a branch on it, fail() is kept out of line so the error path stays out of the way.
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EXPECTED_COLD __attribute__((noinline, cold))	// building an Error copies its message: out of the caller's loop, or the loop doesn't vectorize
+#elif defined(_MSC_VER)
+#define EXPECTED_COLD __declspec(noinline)
+#else
+#define EXPECTED_COLD
+#endif
+
+namespace err {
+
+enum class Errc : uint8_t { InvalidArgument = 1, OutOfRange, Overflow, NotFound, Io, Other };
+
+inline const char *errcName(Errc e)
+{
+	switch (e) {
+	case Errc::InvalidArgument: return "invalid argument";
+	case Errc::OutOfRange: return "out of range";
+	case Errc::Overflow: return "overflow";
+	case Errc::NotFound: return "not found";
+	case Errc::Io: return "i/o error";
+	case Errc::Other: return "error";
+	}
+	return "?";
+}
+
+// Error code plus a short message, kept inside the object (longer messages are cut off). Trivially copyable, never allocates
+class Error {
+public:
+	static constexpr size_t maxMessage = 30;
+
+	constexpr Error(Errc code = Errc::Other, std::string_view message = {}) : errc(code), len(static_cast<uint8_t>(message.size() < maxMessage ? message.size() : maxMessage))
+	{
+		for (size_t i = 0; i < len; i++)
+			text[i] = message[i];
+	}
+
+	constexpr Errc code() const { return errc; }
+	constexpr std::string_view message() const { return { text, len }; }
+
+private:
+	Errc errc;
+	uint8_t len;
+	char text[maxMessage] = {};
+};
+
+template <typename E>
+class unexpected {
+public:
+	constexpr explicit unexpected(E e) : err(std::move(e)) {}
+
+	constexpr const E &error() const & { return err; }
+	constexpr E &&error() && { return std::move(err); }
+
+private:
+	E err;
+};
+
+template <typename E>
+unexpected(E) -> unexpected<E>;
+
+EXPECTED_COLD inline unexpected<Error> fail(Errc code, std::string_view message = {}) { return unexpected<Error>(Error(code, message)); }
+
+template <typename E>
+class bad_expected_access : public std::exception {
+public:
+	explicit bad_expected_access(E e) : err(std::move(e)) {}
+	const char *what() const noexcept override { return "bad expected access"; }
+	const E &error() const { return err; }
+
+private:
+	E err;
+};
+
+template <typename T, typename E = Error>
+class expected;
+
+namespace detail {
+
+template <typename T>
+struct IsExpected : std::false_type {};
+template <typename T, typename E>
+struct IsExpected<expected<T, E>> : std::true_type {};
+
+} // namespace detail
+
+template <typename T, typename E>
+class expected {
+public:
+	using value_type = T;
+	using error_type = E;
+
+	expected() : ok(true) { ::new (&val) T(); }
+
+	template <typename U = T, typename = std::enable_if_t<std::is_constructible_v<T, U &&> && !std::is_same_v<std::decay_t<U>, expected> &&
+		!std::is_same_v<std::decay_t<U>, unexpected<E>>>>
+	expected(U &&v) : ok(true) { ::new (&val) T(std::forward<U>(v)); }
+
+	template <typename G>
+	expected(const unexpected<G> &u) : ok(false) { ::new (&err) E(u.error()); }
+	template <typename G>
+	expected(unexpected<G> &&u) : ok(false) { ::new (&err) E(std::move(u).error()); }
+
+	expected(const expected &other) : ok(other.ok) { constructFrom(other); }
+	expected(expected &&other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<E>) : ok(other.ok)
+	{
+		constructFrom(std::move(other));
+	}
+
+	expected &operator=(const expected &other)
+	{
+		if (this != &other)
+			assign(other);
+		return *this;
+	}
+
+	expected &operator=(expected &&other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<E>)
+	{
+		if (this != &other)
+			assign(std::move(other));
+		return *this;
+	}
+
+	~expected() { destroy(); }
+
+	bool has_value() const { return ok; }
+	explicit operator bool() const { return ok; }
+
+	T &value() &
+	{
+		if (!ok)
+			throw bad_expected_access<E>(err);
+		return val;
+	}
+	const T &value() const &
+	{
+		if (!ok)
+			throw bad_expected_access<E>(err);
+		return val;
+	}
+	T &&value() && { return std::move(value()); }
+
+	// Unchecked, like std::optional
+	T &operator*() & { return val; }
+	const T &operator*() const & { return val; }
+	T &&operator*() && { return std::move(val); }
+	T *operator->() { return &val; }
+	const T *operator->() const { return &val; }
+
+	const E &error() const & { return err; }
+	E &&error() && { return std::move(err); }
+
+	template <typename U>
+	T value_or(U &&fallback) const & { return ok ? val : static_cast<T>(std::forward<U>(fallback)); }
+
+	// f(value) -> expected<U, E>, only called on success
+	template <typename F>
+	auto and_then(F &&f) const &
+	{
+		using R = std::invoke_result_t<F, const T &>;
+		static_assert(detail::IsExpected<R>::value, "and_then needs a function that returns an expected");
+		return ok ? std::forward<F>(f)(val) : R(unexpected<E>(err));
+	}
+	template <typename F>
+	auto and_then(F &&f) &&
+	{
+		using R = std::invoke_result_t<F, T &&>;
+		static_assert(detail::IsExpected<R>::value, "and_then needs a function that returns an expected");
+		return ok ? std::forward<F>(f)(std::move(val)) : R(unexpected<E>(std::move(err)));
+	}
+
+	// f(value) -> U, wrapped into expected<U, E>
+	template <typename F>
+	auto transform(F &&f) const &
+	{
+		using U = std::invoke_result_t<F, const T &>;
+		if constexpr (std::is_void_v<U>) {
+			if (!ok)
+				return expected<void, E>(unexpected<E>(err));
+			std::forward<F>(f)(val);
+			return expected<void, E>();
+		} else {
+			return ok ? expected<U, E>(std::forward<F>(f)(val)) : expected<U, E>(unexpected<E>(err));
+		}
+	}
+
+	// f(error) -> expected<T, G>, only called on error (recover, or turn it into another error)
+	template <typename F>
+	auto or_else(F &&f) const &
+	{
+		using R = std::invoke_result_t<F, const E &>;
+		static_assert(detail::IsExpected<R>::value, "or_else needs a function that returns an expected");
+		return ok ? R(val) : std::forward<F>(f)(err);
+	}
+
+	// f(error) -> G, wrapped into expected<T, G>
+	template <typename F>
+	auto transform_error(F &&f) const &
+	{
+		using G = std::invoke_result_t<F, const E &>;
+		return ok ? expected<T, G>(val) : expected<T, G>(unexpected<G>(std::forward<F>(f)(err)));
+	}
+
+private:
+	// Other is const expected & or expected &&, ok already set from it
+	template <typename Other>
+	void constructFrom(Other &&other)
+	{
+		if (ok)
+			::new (&val) T(std::forward<Other>(other).val);
+		else
+			::new (&err) E(std::forward<Other>(other).err);
+	}
+
+	// The old member is only destroyed once nothing can throw any more: if building the new one can throw, it's built into a temporary
+	// first (then *this is unchanged when it does) and moved in from there
+	template <typename Other>
+	void assign(Other &&other)
+	{
+		constexpr bool nothrowBuild = std::is_nothrow_constructible_v<T, decltype((std::forward<Other>(other).val))> &&
+			std::is_nothrow_constructible_v<E, decltype((std::forward<Other>(other).err))>;
+		if constexpr (nothrowBuild) {
+			destroy();
+			ok = other.ok;
+			constructFrom(std::forward<Other>(other));
+		} else {
+			static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<E>,
+				"assigning an expected whose copy can throw needs T and E to be nothrow movable (like std::expected)");
+			expected tmp(std::forward<Other>(other));
+			destroy();
+			ok = tmp.ok;
+			constructFrom(std::move(tmp));
+		}
+	}
+
+	void destroy()
+	{
+		if (ok)
+			val.~T();
+		else
+			err.~E();
+	}
+
+	union {
+		T val;
+		E err;
+	};
+	bool ok;
+};
+
+// No value, success or an error: for functions like fnoe() that only report whether they worked
+template <typename E>
+class expected<void, E> {
+public:
+	using value_type = void;
+	using error_type = E;
+
+	expected() : ok(true) {}
+	template <typename G>
+	expected(const unexpected<G> &u) : ok(false) { ::new (&err) E(u.error()); }
+	template <typename G>
+	expected(unexpected<G> &&u) : ok(false) { ::new (&err) E(std::move(u).error()); }
+
+	expected(const expected &other) : ok(other.ok)
+	{
+		if (!ok)
+			::new (&err) E(other.err);
+	}
+
+	// The error is copied before the old one is destroyed, so a throwing copy leaves *this as it was
+	expected &operator=(const expected &other)
+	{
+		if (this != &other) {
+			if (other.ok) {
+				destroy();
+				ok = true;
+			} else if constexpr (std::is_nothrow_copy_constructible_v<E>) {
+				destroy();
+				ok = false;
+				::new (&err) E(other.err);
+			} else {
+				static_assert(std::is_nothrow_move_constructible_v<E>, "assigning an expected whose copy can throw needs E to be nothrow movable (like std::expected)");
+				E copy(other.err);
+				destroy();
+				ok = false;
+				::new (&err) E(std::move(copy));
+			}
+		}
+		return *this;
+	}
+
+	~expected() { destroy(); }
+
+	bool has_value() const { return ok; }
+	explicit operator bool() const { return ok; }
+
+	void value() const
+	{
+		if (!ok)
+			throw bad_expected_access<E>(err);
+	}
+
+	const E &error() const & { return err; }
+
+	template <typename F>
+	auto and_then(F &&f) const
+	{
+		using R = std::invoke_result_t<F>;
+		static_assert(detail::IsExpected<R>::value, "and_then needs a function that returns an expected");
+		return ok ? std::forward<F>(f)() : R(unexpected<E>(err));
+	}
+
+	template <typename F>
+	auto or_else(F &&f) const
+	{
+		using R = std::invoke_result_t<F, const E &>;
+		static_assert(detail::IsExpected<R>::value, "or_else needs a function that returns an expected");
+		return ok ? R() : std::forward<F>(f)(err);
+	}
+
+private:
+	void destroy()
+	{
+		if (!ok)
+			err.~E();
+	}
+
+	union {
+		E err;
+	};
+	bool ok;
+};
+
+// x | f  is  x.and_then(f), so steps read left to right, and a pack of them folds: (x | ... | steps)
+template <typename T, typename E, typename F>
+auto operator|(const expected<T, E> &x, F &&f) { return x.and_then(std::forward<F>(f)); }
+template <typename T, typename E, typename F>
+auto operator|(expected<T, E> &&x, F &&f) { return std::move(x).and_then(std::forward<F>(f)); }
+
+// Runs the steps one after the other, each gets the previous one's value, stops at the first error
+template <typename T, typename E, typename... Steps>
+auto chain(expected<T, E> x, Steps &&... steps)
+{
+	return (std::move(x) | ... | std::forward<Steps>(steps));
+}
+
+// All the values as a tuple, or the first error (in argument order)
+template <typename E, typename... T>
+expected<std::tuple<T...>, E> collect(const expected<T, E> &... xs)
+{
+	const E *first = nullptr;
+	((first == nullptr && !xs ? void(first = &xs.error()) : void()), ...);
+	if (first)
+		return unexpected<E>(*first);
+	return std::tuple<T...>(*xs...);
+}
+
+} // namespace err
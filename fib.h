@@ -0,0 +1,228 @@
+#pragma once
+
+// Fibonacci engine, the fast alternatives to the naive fib/fibCE in constexpr.cpp (those are exponential, fibCE(40) alone blows
+// g++'s default -fconstexpr-ops-limit and takes ~30s to compile).
+//
+//	fibFast<T>(n)		fast doubling, O(log n), usable both at runtime and in constexpr context
+//	fibChecked<T>(n)	same, but throws std::overflow_error if F(n) doesn't fit in T (in a constexpr context that becomes a compile error)
+//	FibMemo<T>			runtime memo table, O(1) after first use, can be shared between threads
+//	fibBig(n)			arbitrary width result (BigUint), for when even 128 bits isn't enough (F(187) and up)
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SIZEOF_INT128__)
+using fib_u128 = unsigned __int128; // gcc/clang extension, MSVC doesn't have it
+#define FIB_HAS_U128
+#endif
+
+// Fast doubling:  F(2k) = F(k) * (2F(k+1) - F(k))     F(2k+1) = F(k)^2 + F(k+1)^2
+// Walks the bits of n from the top, keeping the pair (F(k), F(k+1)). T must be an unsigned type: everything is done modulo 2^bits,
+// so transient wrap-around (e.g. in 2F(k+1)) doesn't matter, the result is exact as long as F(n) itself fits in T.
+template <typename T = uint64_t>
+constexpr T fibFast(unsigned n)
+{
+	static_assert(static_cast<T>(T(0) - T(1)) > T(0), "fibFast needs an unsigned type");
+	T a = 0, b = 1; // F(0), F(1)
+	for (int bit = 31; bit >= 0; bit--) {
+		T c = a * (T(2) * b - a);	// F(2k)
+		T d = a * a + b * b;		// F(2k+1)
+		if ((n >> bit) & 1u) {
+			a = d;
+			b = c + d;
+		} else {
+			a = c;
+			b = d;
+		}
+	}
+	return a;
+}
+
+// Largest n where F(n) still fits in T (93 for uint64_t, 186 for 128 bits)
+template <typename T = uint64_t>
+constexpr unsigned fibMaxIndex()
+{
+	T a = 0, b = 1;
+	unsigned n = 1;
+	while (static_cast<T>(a + b) >= b) { // unsigned wrap means overflow
+		T next = a + b;
+		a = b;
+		b = next;
+		n++;
+	}
+	return n;
+}
+
+template <typename T = uint64_t>
+constexpr T fibChecked(unsigned n)
+{
+	if (n > fibMaxIndex<T>())
+		throw std::overflow_error("fibChecked: F(" + std::to_string(n) + ") does not fit in the result type");
+	return fibFast<T>(n);
+}
+
+// Memo table shared between threads. Lookups of already known values only take a shared (reader) lock,
+// extending the table takes the exclusive lock and is linear from the last known value, so every F(i) is computed once.
+template <typename T = uint64_t>
+class FibMemo {
+public:
+	FibMemo() : table{ 0, 1 } {}
+
+	T get(unsigned n)
+	{
+		if (n > fibMaxIndex<T>())
+			throw std::overflow_error("FibMemo: F(" + std::to_string(n) + ") does not fit in the result type");
+		{
+			std::shared_lock<std::shared_mutex> lock(m);
+			if (n < table.size())
+				return table[n];
+		}
+		std::unique_lock<std::shared_mutex> lock(m);
+		while (table.size() <= n) // another thread may have extended it while we waited for the lock
+			table.push_back(table[table.size() - 1] + table[table.size() - 2]);
+		return table[n];
+	}
+
+	size_t size() const
+	{
+		std::shared_lock<std::shared_mutex> lock(m);
+		return table.size();
+	}
+
+private:
+	mutable std::shared_mutex m;
+	std::vector<T> table;
+};
+
+// Minimal arbitrary width unsigned integer, just enough for fast doubling (add, sub, mul, to decimal string). Limbs are base 2^32, least significant first.
+class BigUint {
+public:
+	BigUint(uint64_t v = 0)
+	{
+		while (v) {
+			limbs.push_back(static_cast<uint32_t>(v));
+			v >>= 32;
+		}
+	}
+
+	friend BigUint operator+(const BigUint &x, const BigUint &y)
+	{
+		BigUint r;
+		r.limbs.resize(std::max(x.limbs.size(), y.limbs.size()) + 1);
+		uint64_t carry = 0;
+		for (size_t i = 0; i < r.limbs.size(); i++) {
+			uint64_t s = carry + x.limb(i) + y.limb(i);
+			r.limbs[i] = static_cast<uint32_t>(s);
+			carry = s >> 32;
+		}
+		r.trim();
+		return r;
+	}
+
+	// x - y, x must be >= y
+	friend BigUint operator-(const BigUint &x, const BigUint &y)
+	{
+		BigUint r;
+		r.limbs.resize(x.limbs.size());
+		int64_t borrow = 0;
+		for (size_t i = 0; i < r.limbs.size(); i++) {
+			int64_t s = static_cast<int64_t>(x.limb(i)) - y.limb(i) - borrow;
+			borrow = s < 0;
+			r.limbs[i] = static_cast<uint32_t>(s + (borrow << 32));
+		}
+		r.trim();
+		return r;
+	}
+
+	friend BigUint operator*(const BigUint &x, const BigUint &y)
+	{
+		BigUint r;
+		if (x.limbs.empty() || y.limbs.empty())
+			return r;
+		r.limbs.assign(x.limbs.size() + y.limbs.size(), 0);
+		for (size_t i = 0; i < x.limbs.size(); i++) {
+			uint64_t carry = 0;
+			for (size_t j = 0; j < y.limbs.size(); j++) {
+				uint64_t cur = r.limbs[i + j] + static_cast<uint64_t>(x.limbs[i]) * y.limbs[j] + carry;
+				r.limbs[i + j] = static_cast<uint32_t>(cur);
+				carry = cur >> 32;
+			}
+			r.limbs[i + y.limbs.size()] = static_cast<uint32_t>(carry);
+		}
+		r.trim();
+		return r;
+	}
+
+	size_t bits() const { return limbs.empty() ? 0 : (limbs.size() - 1) * 32 + (32 - countLeadingZeros(limbs.back())); }
+
+	std::string toString() const
+	{
+		if (limbs.empty())
+			return "0";
+		// repeatedly divide by 10^9 and collect the remainders
+		std::vector<uint32_t> cur(limbs);
+		std::string digits;
+		while (!cur.empty()) {
+			uint64_t rem = 0;
+			for (size_t i = cur.size(); i-- > 0;) {
+				uint64_t v = (rem << 32) | cur[i];
+				cur[i] = static_cast<uint32_t>(v / 1000000000u);
+				rem = v % 1000000000u;
+			}
+			while (!cur.empty() && cur.back() == 0)
+				cur.pop_back();
+			for (int d = 0; d < 9 && (!cur.empty() || rem); d++) {
+				digits += static_cast<char>('0' + rem % 10);
+				rem /= 10;
+			}
+		}
+		return std::string(digits.rbegin(), digits.rend());
+	}
+
+private:
+	uint32_t limb(size_t i) const { return i < limbs.size() ? limbs[i] : 0; }
+	void trim() { while (!limbs.empty() && limbs.back() == 0) limbs.pop_back(); }
+	static int countLeadingZeros(uint32_t v) { int n = 0; while (!(v & 0x80000000u)) { v <<= 1; n++; } return n; }
+
+	std::vector<uint32_t> limbs;
+};
+
+// Same fast doubling as fibFast, but without the modular tricks since BigUint never wraps (so 2F(k+1) - F(k) must not go negative, and it doesn't)
+inline BigUint fibBig(unsigned n)
+{
+	BigUint a = 0, b = 1;
+	for (int bit = 31; bit >= 0; bit--) {
+		if (!(n >> bit))
+			continue; // leading zero bits, (F(0), F(1)) stays as it is
+		BigUint c = a * (b + b - a);
+		BigUint d = a * a + b * b;
+		if ((n >> bit) & 1u) {
+			a = d;
+			b = c + d;
+		} else {
+			a = std::move(c);
+			b = std::move(d);
+		}
+	}
+	return a;
+}
+
+#if defined(FIB_HAS_U128)
+// cout has no operator<< for 128 bit ints
+inline std::string u128ToString(fib_u128 v)
+{
+	if (v == 0)
+		return "0";
+	std::string s;
+	while (v) {
+		s += static_cast<char>('0' + static_cast<int>(v % 10));
+		v /= 10;
+	}
+	return std::string(s.rbegin(), s.rend());
+}
+#endif
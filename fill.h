@@ -0,0 +1,444 @@
+#pragma once
+
+// Buffer fill library: constant fills, ramps (the (i++) % 256 sequence from main) and repeating patterns, with SSE2/AVX2/AVX-512 kernels
+// picked at runtime from CPUID, and a scalar fallback for everything else (non-x86, or ancient x86).
+//
+// The kernels are compiled with per-function target attributes, so no -mavx2 etc is needed on the command line and the exe still runs on
+// cpus without AVX (the dispatcher just never calls those kernels there). MSVC doesn't need the attributes, intrinsics are always available.
+//
+//	buf::fillConst(p, 0x77, size);					// like memset
+//	buf::fillRamp(p, size);							// p[i] = i % 256
+//	buf::fillPattern(p, size, pattern, patternLen);	// p[i] = pattern[i % patternLen]
+//	buf::kernelsFor(buf::Isa::SSE2).fillConst(...)	// force a specific kernel (benchmarks)
+//
+// Fills of streamingThreshold bytes or more (default: the size of the last level cache) use non-temporal (streaming) stores. Those go
+// straight to memory through the write-combining buffers instead of first reading every line into the cache (read-for-ownership) and
+// then evicting everything else that was in there. Below the threshold normal stores win, since the data is likely to be read again soon.
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <cstring>
+#include <initializer_list>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BUF_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>	// __cpuid, __cpuidex
+#endif
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>	// sysconf
+#endif
+
+#if defined(BUF_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BUF_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BUF_TARGET(isa)
+#endif
+
+namespace buf {
+
+enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+inline const char *isaName(Isa isa)
+{
+	switch (isa) {
+	case Isa::SSE2: return "sse2";
+	case Isa::AVX2: return "avx2";
+	case Isa::AVX512: return "avx512";
+	default: return "scalar";
+	}
+}
+
+inline bool isaSupported(Isa isa)
+{
+	if (isa == Isa::Scalar)
+		return true;
+#if defined(BUF_X86) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	switch (isa) {
+	case Isa::SSE2: return __builtin_cpu_supports("sse2");
+	case Isa::AVX2: return __builtin_cpu_supports("avx2");
+	case Isa::AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"); // byte adds need BW
+	default: return false;
+	}
+#elif defined(BUF_X86) && defined(_MSC_VER)
+	int r1[4], r7[4];
+	__cpuid(r1, 1);
+	__cpuidex(r7, 7, 0);
+	bool osAvx = (r1[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;			// OS saves ymm state
+	bool osAvx512 = osAvx && (_xgetbv(0) & 0xe6) == 0xe6;					// ...and zmm/opmask state
+	switch (isa) {
+	case Isa::SSE2: return (r1[3] & (1 << 26)) != 0;
+	case Isa::AVX2: return osAvx && (r7[1] & (1 << 5));
+	case Isa::AVX512: return osAvx512 && (r7[1] & (1 << 16)) && (r7[1] & (1 << 30));
+	default: return false;
+	}
+#else
+	return false;
+#endif
+}
+
+using FillConstFn = void (*)(uint8_t *dst, uint8_t value, size_t n);
+using FillRampFn = void (*)(uint8_t *dst, size_t n, uint8_t start);
+// block holds the pattern repeated to blockLen bytes, blockLen a multiple of 64 (every vector width)
+using FillBlockFn = void (*)(uint8_t *dst, size_t n, const uint8_t *block, size_t blockLen);
+
+struct Kernels {
+	Isa isa;
+	FillConstFn fillConst;
+	FillRampFn fillRamp;
+	FillBlockFn fillBlock;
+	FillConstFn fillConstNT;	// non-temporal versions, end with a store fence
+	FillRampFn fillRampNT;
+};
+
+enum class Store { Auto, Temporal, NonTemporal }; // Auto = non-temporal from streamingThreshold and up
+
+inline size_t defaultStreamingThreshold()
+{
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+	long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	if (llc > 0)
+		return static_cast<size_t>(llc);
+#endif
+	return 8 * 1024 * 1024;
+}
+
+inline std::atomic<size_t> streamingThreshold { defaultStreamingThreshold() };
+
+// 0..63, added to the start value to get the first ramp vector
+alignas(64) inline constexpr uint8_t rampBase[64] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+	32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63 };
+
+// Scalar versions, also used for the tails of the simd kernels
+
+inline void fillConstScalar(uint8_t *dst, uint8_t value, size_t n)
+{
+	// 8 bytes at a time, memcpy of a uint64_t is the portable way to do an unaligned store
+	uint64_t v = 0x0101010101010101ull * value;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		std::memcpy(dst + i, &v, 8);
+	for (; i < n; i++)
+		dst[i] = value;
+}
+
+inline void fillRampScalar(uint8_t *dst, size_t n, uint8_t start)
+{
+	for (size_t i = 0; i < n; i++)
+		dst[i] = static_cast<uint8_t>(start + i);
+}
+
+inline void fillBlockScalar(uint8_t *dst, size_t n, const uint8_t *block, size_t blockLen)
+{
+	for (size_t i = 0, off = 0; i < n; i++) {
+		dst[i] = block[off];
+		if (++off == blockLen)
+			off = 0;
+	}
+}
+
+#if defined(BUF_X86)
+
+// Bytes of regular stores needed before dst is aligned for the streaming stores (which require alignment)
+inline size_t headToAlign(const uint8_t *dst, size_t align, size_t n)
+{
+	size_t head = (align - reinterpret_cast<uintptr_t>(dst) % align) % align;
+	return head < n ? head : n;
+}
+
+// SSE2, 16 bytes per store
+
+BUF_TARGET("sse2") inline void fillConstSSE2(uint8_t *dst, uint8_t value, size_t n)
+{
+	__m128i v = _mm_set1_epi8(static_cast<char>(value));
+	size_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 16), v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 32), v);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 48), v);
+	}
+	for (; i + 16 <= n; i += 16)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+	fillConstScalar(dst + i, value, n - i);
+}
+
+BUF_TARGET("sse2") inline void fillRampSSE2(uint8_t *dst, size_t n, uint8_t start)
+{
+	// byte adds wrap around at 256 by themselves, which is exactly the % 256
+	__m128i v = _mm_add_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(rampBase)), _mm_set1_epi8(static_cast<char>(start)));
+	const __m128i step = _mm_set1_epi8(16);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+		v = _mm_add_epi8(v, step);
+	}
+	fillRampScalar(dst + i, n - i, static_cast<uint8_t>(start + i));
+}
+
+BUF_TARGET("sse2") inline void fillBlockSSE2(uint8_t *dst, size_t n, const uint8_t *block, size_t blockLen)
+{
+	size_t i = 0, off = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + off)));
+		if ((off += 16) == blockLen)
+			off = 0;
+	}
+	fillBlockScalar(dst + i, n - i, block + off, blockLen - off);
+}
+
+BUF_TARGET("sse2") inline void fillConstNTSSE2(uint8_t *dst, uint8_t value, size_t n)
+{
+	size_t i = headToAlign(dst, 16, n);
+	fillConstScalar(dst, value, i);
+	__m128i v = _mm_set1_epi8(static_cast<char>(value));
+	for (; i + 64 <= n; i += 64) {
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), v);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i + 16), v);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i + 32), v);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i + 48), v);
+	}
+	for (; i + 16 <= n; i += 16)
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), v);
+	_mm_sfence(); // streaming stores are weakly ordered, make them visible before anything after us (e.g. a release to another thread)
+	fillConstScalar(dst + i, value, n - i);
+}
+
+BUF_TARGET("sse2") inline void fillRampNTSSE2(uint8_t *dst, size_t n, uint8_t start)
+{
+	size_t i = headToAlign(dst, 16, n);
+	fillRampScalar(dst, i, start);
+	__m128i v = _mm_add_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(rampBase)), _mm_set1_epi8(static_cast<char>(start + i)));
+	const __m128i step = _mm_set1_epi8(16);
+	for (; i + 16 <= n; i += 16) {
+		_mm_stream_si128(reinterpret_cast<__m128i *>(dst + i), v);
+		v = _mm_add_epi8(v, step);
+	}
+	_mm_sfence();
+	fillRampScalar(dst + i, n - i, static_cast<uint8_t>(start + i));
+}
+
+// AVX2, 32 bytes per store
+
+BUF_TARGET("avx2") inline void fillConstAVX2(uint8_t *dst, uint8_t value, size_t n)
+{
+	__m256i v = _mm256_set1_epi8(static_cast<char>(value));
+	size_t i = 0;
+	for (; i + 128 <= n; i += 128) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 32), v);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 64), v);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 96), v);
+	}
+	for (; i + 32 <= n; i += 32)
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+	fillConstScalar(dst + i, value, n - i);
+}
+
+BUF_TARGET("avx2") inline void fillRampAVX2(uint8_t *dst, size_t n, uint8_t start)
+{
+	__m256i v = _mm256_add_epi8(_mm256_load_si256(reinterpret_cast<const __m256i *>(rampBase)), _mm256_set1_epi8(static_cast<char>(start)));
+	const __m256i step = _mm256_set1_epi8(32);
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+		v = _mm256_add_epi8(v, step);
+	}
+	fillRampScalar(dst + i, n - i, static_cast<uint8_t>(start + i));
+}
+
+BUF_TARGET("avx2") inline void fillBlockAVX2(uint8_t *dst, size_t n, const uint8_t *block, size_t blockLen)
+{
+	size_t i = 0, off = 0;
+	for (; i + 32 <= n; i += 32) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + off)));
+		if ((off += 32) == blockLen)
+			off = 0;
+	}
+	fillBlockScalar(dst + i, n - i, block + off, blockLen - off);
+}
+
+BUF_TARGET("avx2") inline void fillConstNTAVX2(uint8_t *dst, uint8_t value, size_t n)
+{
+	size_t i = headToAlign(dst, 32, n);
+	fillConstScalar(dst, value, i);
+	__m256i v = _mm256_set1_epi8(static_cast<char>(value));
+	for (; i + 128 <= n; i += 128) {
+		_mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), v);
+		_mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 32), v);
+		_mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 64), v);
+		_mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i + 96), v);
+	}
+	for (; i + 32 <= n; i += 32)
+		_mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), v);
+	_mm_sfence();
+	fillConstScalar(dst + i, value, n - i);
+}
+
+BUF_TARGET("avx2") inline void fillRampNTAVX2(uint8_t *dst, size_t n, uint8_t start)
+{
+	size_t i = headToAlign(dst, 32, n);
+	fillRampScalar(dst, i, start);
+	__m256i v = _mm256_add_epi8(_mm256_load_si256(reinterpret_cast<const __m256i *>(rampBase)), _mm256_set1_epi8(static_cast<char>(start + i)));
+	const __m256i step = _mm256_set1_epi8(32);
+	for (; i + 32 <= n; i += 32) {
+		_mm256_stream_si256(reinterpret_cast<__m256i *>(dst + i), v);
+		v = _mm256_add_epi8(v, step);
+	}
+	_mm_sfence();
+	fillRampScalar(dst + i, n - i, static_cast<uint8_t>(start + i));
+}
+
+// AVX-512 (F + BW), 64 bytes per store
+
+BUF_TARGET("avx512f,avx512bw") inline void fillConstAVX512(uint8_t *dst, uint8_t value, size_t n)
+{
+	__m512i v = _mm512_set1_epi8(static_cast<char>(value));
+	size_t i = 0;
+	for (; i + 256 <= n; i += 256) {
+		_mm512_storeu_si512(dst + i, v);
+		_mm512_storeu_si512(dst + i + 64, v);
+		_mm512_storeu_si512(dst + i + 128, v);
+		_mm512_storeu_si512(dst + i + 192, v);
+	}
+	for (; i + 64 <= n; i += 64)
+		_mm512_storeu_si512(dst + i, v);
+	fillConstScalar(dst + i, value, n - i);
+}
+
+BUF_TARGET("avx512f,avx512bw") inline void fillRampAVX512(uint8_t *dst, size_t n, uint8_t start)
+{
+	__m512i v = _mm512_add_epi8(_mm512_load_si512(rampBase), _mm512_set1_epi8(static_cast<char>(start)));
+	const __m512i step = _mm512_set1_epi8(64);
+	size_t i = 0;
+	for (; i + 64 <= n; i += 64) {
+		_mm512_storeu_si512(dst + i, v);
+		v = _mm512_add_epi8(v, step);
+	}
+	fillRampScalar(dst + i, n - i, static_cast<uint8_t>(start + i));
+}
+
+BUF_TARGET("avx512f,avx512bw") inline void fillBlockAVX512(uint8_t *dst, size_t n, const uint8_t *block, size_t blockLen)
+{
+	size_t i = 0, off = 0;
+	for (; i + 64 <= n; i += 64) {
+		_mm512_storeu_si512(dst + i, _mm512_loadu_si512(block + off));
+		if ((off += 64) == blockLen)
+			off = 0;
+	}
+	fillBlockScalar(dst + i, n - i, block + off, blockLen - off);
+}
+
+BUF_TARGET("avx512f,avx512bw") inline void fillConstNTAVX512(uint8_t *dst, uint8_t value, size_t n)
+{
+	size_t i = headToAlign(dst, 64, n);
+	fillConstScalar(dst, value, i);
+	__m512i v = _mm512_set1_epi8(static_cast<char>(value));
+	for (; i + 256 <= n; i += 256) {
+		_mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i), v);
+		_mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 64), v);
+		_mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 128), v);
+		_mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i + 192), v);
+	}
+	for (; i + 64 <= n; i += 64)
+		_mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i), v);
+	_mm_sfence();
+	fillConstScalar(dst + i, value, n - i);
+}
+
+BUF_TARGET("avx512f,avx512bw") inline void fillRampNTAVX512(uint8_t *dst, size_t n, uint8_t start)
+{
+	size_t i = headToAlign(dst, 64, n);
+	fillRampScalar(dst, i, start);
+	__m512i v = _mm512_add_epi8(_mm512_load_si512(rampBase), _mm512_set1_epi8(static_cast<char>(start + i)));
+	const __m512i step = _mm512_set1_epi8(64);
+	for (; i + 64 <= n; i += 64) {
+		_mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i), v);
+		v = _mm512_add_epi8(v, step);
+	}
+	_mm_sfence();
+	fillRampScalar(dst + i, n - i, static_cast<uint8_t>(start + i));
+}
+
+#endif // BUF_X86
+
+// Kernels for a given isa. Doesn't check isaSupported, that is up to the caller (kernels() below does it)
+inline Kernels kernelsFor(Isa isa)
+{
+	switch (isa) {
+#if defined(BUF_X86)
+	case Isa::SSE2: return { isa, fillConstSSE2, fillRampSSE2, fillBlockSSE2, fillConstNTSSE2, fillRampNTSSE2 };
+	case Isa::AVX2: return { isa, fillConstAVX2, fillRampAVX2, fillBlockAVX2, fillConstNTAVX2, fillRampNTAVX2 };
+	case Isa::AVX512: return { isa, fillConstAVX512, fillRampAVX512, fillBlockAVX512, fillConstNTAVX512, fillRampNTAVX512 };
+#endif
+	default: return { Isa::Scalar, fillConstScalar, fillRampScalar, fillBlockScalar, fillConstScalar, fillRampScalar }; // no streaming stores without simd
+	}
+}
+
+inline Isa bestIsa()
+{
+	for (Isa isa : { Isa::AVX512, Isa::AVX2, Isa::SSE2 })
+		if (isaSupported(isa))
+			return isa;
+	return Isa::Scalar;
+}
+
+// Best kernels for this cpu, detected once (thread safe, function local statics are initialized once since C++11)
+inline const Kernels &kernels()
+{
+	static const Kernels best = kernelsFor(bestIsa());
+	return best;
+}
+
+inline bool useStreaming(size_t n, Store store)
+{
+	return store == Store::NonTemporal || (store == Store::Auto && n >= streamingThreshold.load(std::memory_order_relaxed));
+}
+
+inline void fillConst(void *dst, uint8_t value, size_t n, const Kernels &k = kernels(), Store store = Store::Auto)
+{
+	(useStreaming(n, store) ? k.fillConstNT : k.fillConst)(static_cast<uint8_t *>(dst), value, n);
+}
+
+// dst[i] = (start + i) % 256
+inline void fillRamp(void *dst, size_t n, uint8_t start = 0, const Kernels &k = kernels(), Store store = Store::Auto)
+{
+	(useStreaming(n, store) ? k.fillRampNT : k.fillRamp)(static_cast<uint8_t *>(dst), n, start);
+}
+
+constexpr size_t maxPatternLen = 256;
+
+// dst[i] = pattern[i % patternLen]. Patterns up to maxPatternLen are expanded to a block of lcm(patternLen, 64) bytes (at most 16 KB, stays in L1)
+// which the kernel then copies out a vector at a time. Longer patterns copy the already written part of dst onto itself, doubling each time.
+inline void fillPattern(void *dst, size_t n, const uint8_t *pattern, size_t patternLen, const Kernels &k = kernels())
+{
+	auto *d = static_cast<uint8_t *>(dst);
+	if (patternLen == 0 || n == 0)
+		return;
+	if (patternLen == 1)
+		return k.fillConst(d, pattern[0], n);
+
+	if (patternLen <= maxPatternLen) {
+		alignas(64) uint8_t block[maxPatternLen * 64];
+		size_t blockLen = patternLen / std::gcd(patternLen, size_t(64)) * 64;
+		for (size_t i = 0; i < blockLen; i++)
+			block[i] = pattern[i % patternLen];
+		return k.fillBlock(d, n, block, blockLen);
+	}
+
+	size_t done = patternLen < n ? patternLen : n;
+	std::memcpy(d, pattern, done);
+	while (done < n) {
+		size_t len = done < n - done ? done : n - done;
+		std::memcpy(d + done, d, len);
+		done += len;
+	}
+}
+
+} // namespace buf
@@ -0,0 +1,116 @@
+#pragma once
+
+// Copy/fill/transform for sizes known at compile time, the A<N> idea applied to the loops: with N a template parameter there is no loop
+// counter, no remainder handling and no size check left at runtime, the compiler sees exactly which moves to emit.
+//
+//	fixed::copy<4>(arr, tmp.arr);									// 4 ints, a single 16 byte move
+//	fixed::copy(arr, tmp.arr);										// N from the array types (built in arrays and std::array)
+//	fixed::fill<64>(p, 0x77);
+//	fixed::transform<1024>(dst, src, [](int x) { return x * 3 + 1; });
+//
+// Up to unrollBytes the whole thing is unrolled (N statements, the compiler merges them into vector moves). Above that it's a loop over
+// blocks of unrollBytes, each block unrolled, plus an unrolled tail: still no runtime bound, and the code doesn't grow with N.
+// Except big copies, those go to memcpy outside of constant expressions: libc's memcpy picks AVX2/AVX-512 moves at
+// runtime, a loop only gets what the compiler flags allow (SSE2 without -march), and that's half the speed from about 1 KB on.
+// All constexpr, so they work in constant expressions too (tables in cetable.h style).
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FIXED_INLINE __attribute__((always_inline)) inline	// the unrolled statements only merge into vector moves when all of it is inlined
+#elif defined(_MSC_VER)
+#define FIXED_INLINE __forceinline
+#else
+#define FIXED_INLINE inline
+#endif
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define FIXED_RUNTIME_MEMCPY	// std::is_constant_evaluated is C++20, the builtin behind it works in C++17 too
+#endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#define FIXED_RUNTIME_MEMCPY
+#endif
+
+namespace fixed {
+
+constexpr size_t unrollBytes = 256;
+
+namespace detail {
+
+template <size_t Offset, typename F, size_t... I>
+FIXED_INLINE constexpr void unrolled(F &&f, std::index_sequence<I...>)
+{
+	(f(Offset + I), ...);
+}
+
+// f(i) for every i in [0, N)
+template <typename T, size_t N, typename F>
+FIXED_INLINE constexpr void forEach(F f)
+{
+	constexpr size_t block = unrollBytes / sizeof(T) > 0 ? unrollBytes / sizeof(T) : 1;
+	if constexpr (N <= block) {
+		unrolled<0>(f, std::make_index_sequence<N>());
+	} else {
+		constexpr size_t whole = N / block * block;
+		for (size_t b = 0; b < whole; b += block)
+			unrolled<0>([&](size_t i) { f(b + i); }, std::make_index_sequence<block>()); // block is a constant, so this is still straight line code
+		unrolled<whole>(f, std::make_index_sequence<N - whole>());
+	}
+}
+
+#if defined(FIXED_RUNTIME_MEMCPY)
+// Not constexpr (asm isn't allowed there before C++20), only ever called at runtime
+inline void libcMemcpy(void *dst, const void *src, size_t bytes)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm("" : "+r"(bytes)); // a size the compiler doesn't know, or it expands the memcpy into its own SSE2 moves again (g++ does up to a few KB)
+#endif
+	std::memcpy(dst, src, bytes);
+}
+#endif
+
+} // namespace detail
+
+template <size_t N, typename T>
+FIXED_INLINE constexpr void copy(T *dst, const T *src)
+{
+#if defined(FIXED_RUNTIME_MEMCPY)
+	if constexpr (N * sizeof(T) > unrollBytes && std::is_trivially_copyable_v<T>) {
+		if (!__builtin_is_constant_evaluated()) {
+			detail::libcMemcpy(dst, src, N * sizeof(T));
+			return;
+		}
+	}
+#endif
+	detail::forEach<T, N>([&](size_t i) { dst[i] = src[i]; });
+}
+
+template <size_t N, typename T>
+FIXED_INLINE constexpr void fill(T *dst, const T &value)
+{
+	detail::forEach<T, N>([&](size_t i) { dst[i] = value; });
+}
+
+// dst[i] = op(src[i]), dst may be src
+template <size_t N, typename Out, typename In, typename Op>
+FIXED_INLINE constexpr void transform(Out *dst, const In *src, Op op)
+{
+	detail::forEach<Out, N>([&](size_t i) { dst[i] = op(src[i]); });
+}
+
+// N from the arrays
+template <typename T, size_t N>
+FIXED_INLINE constexpr void copy(T (&dst)[N], const T (&src)[N]) { copy<N>(dst, src); }
+template <typename T, size_t N>
+FIXED_INLINE constexpr void copy(std::array<T, N> &dst, const std::array<T, N> &src) { copy<N>(dst.data(), src.data()); }
+template <typename T, size_t N>
+FIXED_INLINE constexpr void fill(T (&dst)[N], const T &value) { fill<N>(dst, value); }
+template <typename T, size_t N>
+FIXED_INLINE constexpr void fill(std::array<T, N> &dst, const T &value) { fill<N>(dst.data(), value); }
+
+} // namespace fixed
@@ -0,0 +1,176 @@
+#pragma once
+
+// Callbacks without std::function. std::function owns a copy of the callable and stores anything bigger than its small buffer
+// (16 bytes in libstdc++, so a lambda capturing three references already) on the heap, and copies allocate again.
+//
+//	void forEachLine(function_ref<void (string_view)> f);			// parameter: takes any lambda, nothing is copied or allocated
+//	forEachLine([&](string_view s) { count += s.size(); });
+//
+//	inplace_function<void (long long), 32> out = nullptr;			// stored callback: owns a copy, inside its own 32 bytes, never allocates
+//	out = [&sink, scale](long long us) { sink.push_back(us * scale); };
+//	if (out) out(42);
+//
+// function_ref<Sig>				two pointers: the callable and a function that calls it. Doesn't own anything, so the callable has to
+//									outlive it: fine for parameters, dangerous as a member or when made from a temporary and kept
+// inplace_function<Sig, Capacity>	owns a copy like std::function, in a buffer of Capacity bytes inside the object. Callables that don't fit
+//									are a compile error (static_assert), not a heap allocation
+//
+// Both can be empty (default constructed, or from nullptr), calling an empty one throws std::bad_function_call like std::function.
+// The names and behaviour follow the C++26 std::function_ref and the inplace_function proposal (P0792, P0043).
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Sig>
+class function_ref;
+
+template <typename R, typename... Args>
+class function_ref<R (Args...)> {
+public:
+	function_ref() = default;
+	function_ref(std::nullptr_t) {}
+
+	template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, function_ref> && std::is_invocable_r_v<R, F &, Args...>>>
+	function_ref(F &&f)
+	{
+		using Fn = std::remove_reference_t<F>;
+		if constexpr (std::is_function_v<Fn> || std::is_function_v<std::remove_pointer_t<std::decay_t<Fn>>>) {
+			// Plain functions have no object to point to, and a function pointer is often a temporary (&func): keep the pointer itself
+			using Ptr = std::decay_t<Fn>;
+			if (static_cast<Ptr>(f) == nullptr)
+				return; // a null function pointer makes an empty one, like std::function
+			target.fn = reinterpret_cast<void (*)()>(static_cast<Ptr>(f));
+			invoker = [](Target t, Args... args) -> R { return std::invoke(reinterpret_cast<Ptr>(t.fn), std::forward<Args>(args)...); };
+		} else {
+			target.obj = const_cast<void *>(static_cast<const void *>(std::addressof(f)));
+			invoker = [](Target t, Args... args) -> R { return std::invoke(*static_cast<Fn *>(t.obj), std::forward<Args>(args)...); };
+		}
+	}
+
+	R operator()(Args... args) const
+	{
+		if (!invoker)
+			throw std::bad_function_call();
+		return invoker(target, std::forward<Args>(args)...);
+	}
+
+	explicit operator bool() const { return invoker != nullptr; }
+
+private:
+	union Target {
+		void *obj;
+		void (*fn)();
+	};
+
+	Target target { nullptr };
+	R (*invoker)(Target, Args...) = nullptr;
+};
+
+template <typename Sig, size_t Capacity = 32, size_t Align = alignof(std::max_align_t)>
+class inplace_function;
+
+template <typename R, typename... Args, size_t Capacity, size_t Align>
+class inplace_function<R (Args...), Capacity, Align> {
+public:
+	inplace_function() = default;
+	inplace_function(std::nullptr_t) {}
+
+	template <typename F, typename Fn = std::decay_t<F>,
+		typename = std::enable_if_t<!std::is_same_v<Fn, inplace_function> && std::is_invocable_r_v<R, Fn &, Args...>>>
+	inplace_function(F &&f)
+	{
+		static_assert(sizeof(Fn) <= Capacity, "callable doesn't fit into this inplace_function, raise Capacity");
+		static_assert(Align % alignof(Fn) == 0, "callable needs more alignment than this inplace_function has, raise Align");
+		static_assert(std::is_copy_constructible_v<Fn>, "inplace_function needs a copyable callable (like std::function)");
+		if constexpr (std::is_pointer_v<Fn> || std::is_member_pointer_v<Fn>) {
+			if (f == nullptr)
+				return; // empty, like std::function from a null pointer
+		}
+		::new (static_cast<void *>(storage)) Fn(std::forward<F>(f));
+		invoker = [](void *p, Args... args) -> R { return std::invoke(*static_cast<Fn *>(p), std::forward<Args>(args)...); };
+		manager = [](Op op, void *dst, void *src) {
+			switch (op) {
+			case Op::Copy: ::new (dst) Fn(*static_cast<const Fn *>(src)); break;
+			case Op::Move: ::new (dst) Fn(std::move(*static_cast<Fn *>(src))); break;
+			case Op::Destroy: static_cast<Fn *>(dst)->~Fn(); break;
+			}
+		};
+	}
+
+	inplace_function(const inplace_function &other) : invoker(other.invoker), manager(other.manager)
+	{
+		if (manager)
+			manager(Op::Copy, storage, const_cast<unsigned char *>(other.storage));
+	}
+
+	// The moved-from one is empty afterwards
+	inplace_function(inplace_function &&other) noexcept : invoker(other.invoker), manager(other.manager)
+	{
+		if (manager) {
+			manager(Op::Move, storage, other.storage);
+			other.reset();
+		}
+	}
+
+	inplace_function &operator=(const inplace_function &other)
+	{
+		if (this != &other) {
+			reset();
+			if (other.manager)
+				other.manager(Op::Copy, storage, const_cast<unsigned char *>(other.storage));
+			invoker = other.invoker;
+			manager = other.manager;
+		}
+		return *this;
+	}
+
+	inplace_function &operator=(inplace_function &&other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			if (other.manager)
+				other.manager(Op::Move, storage, other.storage);
+			invoker = other.invoker;
+			manager = other.manager;
+			other.reset();
+		}
+		return *this;
+	}
+
+	inplace_function &operator=(std::nullptr_t)
+	{
+		reset();
+		return *this;
+	}
+
+	~inplace_function() { reset(); }
+
+	// Like std::function, calls the stored callable even though this is const
+	R operator()(Args... args) const
+	{
+		if (!invoker)
+			throw std::bad_function_call();
+		return invoker(const_cast<unsigned char *>(storage), std::forward<Args>(args)...);
+	}
+
+	explicit operator bool() const { return invoker != nullptr; }
+
+private:
+	enum class Op { Copy, Move, Destroy };
+
+	void reset()
+	{
+		if (manager)
+			manager(Op::Destroy, storage, nullptr);
+		invoker = nullptr;
+		manager = nullptr;
+	}
+
+	alignas(Align) unsigned char storage[Capacity];
+	R (*invoker)(void *, Args...) = nullptr;			// directly in the object, a call is one indirect jump like a virtual call
+	void (*manager)(Op, void *, void *) = nullptr;	// copying/moving/destroying, off the call path
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+// A file mapped into memory, so fills/generates can write their output straight into the file (the page cache, really) instead of into a heap
+// buffer that then gets copied out with write():
+//
+//	MappedFile out("frame.raw", size);			// creates/truncates the file at that size and maps it for writing
+//	out.advise(MapAdvice::Sequential);
+//	buf::fillRamp(out.data(), out.size());		// or par::generate etc, anything that takes a pointer
+//	out.sync();									// msync: wait until it's on disk (skip it and the kernel writes it back in its own time)
+//
+//	MappedFile in("frame.raw");					// existing file, read only
+//
+// Errors (can't open, can't map, disk full) throw std::system_error.
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+enum class MapAdvice { Normal, Sequential, Random, WillNeed, DontNeed };
+
+class MappedFile {
+public:
+	// Create (or truncate) path with size bytes, mapped read/write
+	MappedFile(const std::string &path, size_t size) : len(size), writable(true)
+	{
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			fail("CreateFile " + path);
+		map();
+#else
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			fail("open " + path);
+		if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+			fail("ftruncate " + path);
+#if defined(__linux__)
+		// Allocate the disk blocks now: a full disk is an exception here rather than a SIGBUS in the middle of a fill (the file would be sparse).
+		// Filesystems that can't do it just stay sparse
+		if (size > 0) {
+			int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+			if (err != 0 && err != EOPNOTSUPP && err != EINVAL) {
+				errno = err;
+				fail("posix_fallocate " + path);
+			}
+		}
+#endif
+		map();
+#endif
+	}
+
+	// Existing file, read only, all of it
+	explicit MappedFile(const std::string &path) : writable(false)
+	{
+#if defined(_WIN32)
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			fail("CreateFile " + path);
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		len = static_cast<size_t>(size.QuadPart);
+#else
+		fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			fail("open " + path);
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+			fail("fstat " + path);
+		len = static_cast<size_t>(st.st_size);
+#endif
+		map();
+	}
+
+	~MappedFile() { close(); }
+
+	MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+	MappedFile &operator=(MappedFile &&other) noexcept
+	{
+		if (this != &other) {
+			close();
+			std::swap(ptr, other.ptr);
+			std::swap(len, other.len);
+			std::swap(writable, other.writable);
+#if defined(_WIN32)
+			std::swap(file, other.file);
+			std::swap(mapping, other.mapping);
+#else
+			std::swap(fd, other.fd);
+#endif
+		}
+		return *this;
+	}
+
+	unsigned char *data() const { return ptr; }
+	size_t size() const { return len; }
+
+	// Tells the kernel how the mapping will be used, Sequential = read ahead more and drop pages behind. Only a hint, ignored where unsupported
+	void advise(MapAdvice a)
+	{
+#if !defined(_WIN32)
+		static const int flags[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED };
+		if (ptr)
+			madvise(ptr, len, flags[static_cast<int>(a)]);
+#else
+		(void)a;
+#endif
+	}
+
+	// Write the dirty pages back to the file. wait = false only starts the write-back (MS_ASYNC)
+	void sync(bool wait = true)
+	{
+		if (!ptr || !writable)
+			return;
+#if defined(_WIN32)
+		if (!FlushViewOfFile(ptr, 0) || (wait && !FlushFileBuffers(file)))
+			fail("FlushViewOfFile");
+#else
+		if (msync(ptr, len, wait ? MS_SYNC : MS_ASYNC) != 0)
+			fail("msync");
+#endif
+	}
+
+	// Unmap and close (the destructor does this too). Doesn't sync, the kernel still writes everything back eventually
+	void close()
+	{
+#if defined(_WIN32)
+		if (ptr)
+			UnmapViewOfFile(ptr);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (ptr)
+			munmap(ptr, len);
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+#endif
+		ptr = nullptr;
+	}
+
+private:
+	void map()
+	{
+		if (len == 0)
+			return; // nothing to map, mmap refuses zero lengths
+#if defined(_WIN32)
+		LARGE_INTEGER size;
+		size.QuadPart = static_cast<LONGLONG>(len);
+		mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, size.HighPart, size.LowPart, nullptr); // also grows the file
+		if (!mapping)
+			fail("CreateFileMapping");
+		ptr = static_cast<unsigned char *>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, len));
+		if (!ptr)
+			fail("MapViewOfFile");
+#else
+		void *p = mmap(nullptr, len, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED)
+			fail("mmap");
+		ptr = static_cast<unsigned char *>(p);
+#endif
+	}
+
+	[[noreturn]] void fail(const std::string &what)
+	{
+#if defined(_WIN32)
+		int err = static_cast<int>(GetLastError());
+#else
+		int err = errno;
+#endif
+		close();
+		throw std::system_error(err, std::system_category(), what);
+	}
+
+	unsigned char *ptr = nullptr;
+	size_t len = 0;
+	bool writable = false;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
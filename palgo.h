@@ -0,0 +1,508 @@
+#pragma once
+
+// Parallel versions of the <algorithm> families listed in main(), with std::execution-like policies, on the ThreadPool (threadpool.h),
+// since <execution> is still commented out (libstdc++ needs TBB for it):
+//
+//	algo::sort(algo::par, v.begin(), v.end());								// parallel merge sort
+//	auto it = algo::find_if(algo::par, v.begin(), v.end(), pred);			// chunks past a match stop early
+//	algo::inclusive_scan(algo::par, v.begin(), v.end(), out.begin());		// two pass prefix sum
+//	algo::set_union(algo::par, a.begin(), a.end(), b.begin(), b.end(), out.begin());
+//	algo::ParallelPolicy mine { { &pool, 4 }, 256 };						// own pool, at most 4 threads, chunks of at least 256 elements
+//
+// Policies:
+//	algo::seq			just calls the std algorithm
+//	algo::par			splits the range in chunks (a few per thread) and runs them on the pool
+//	algo::par_unseq		same, and the per-element loops tell the compiler the iterations are independent (GCC ivdep etc) so it can
+//						vectorize them even when it can't prove that itself. Only for functions without side effects on shared data
+//
+// Results are the same as the std versions, in the same order (sort isn't stable, stable_sort is, scans apply op in a different grouping,
+// so op has to be associative). Iterators have to be random access, outputs too. Unlike std with a policy an exception thrown by an
+// element function doesn't terminate: the first one is rethrown once all chunks are done (with some of the output written).
+// Small ranges (below the grain, or a pool without workers) take the serial path.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "parbuf.h"
+#include "threadpool.h"
+
+#if defined(__clang__)
+#define ALGO_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define ALGO_IVDEP _Pragma("GCC ivdep")
+#elif defined(_MSC_VER)
+#define ALGO_IVDEP __pragma(loop(ivdep))
+#else
+#define ALGO_IVDEP
+#endif
+
+namespace algo {
+
+struct SequencedPolicy {};
+struct ParallelPolicy {
+	::par::Config cfg;	// pool and thread limit, like the par:: buffer functions
+	size_t grain = 0;	// least elements per chunk, 0 = defaultGrain
+};
+struct ParallelUnsequencedPolicy : ParallelPolicy {};
+
+inline constexpr SequencedPolicy seq {};
+inline constexpr ParallelPolicy par {};
+inline constexpr ParallelUnsequencedPolicy par_unseq {};
+
+constexpr size_t defaultGrain = 2048;
+
+namespace detail {
+
+template <typename Policy>
+constexpr bool isSeq = std::is_same_v<Policy, SequencedPolicy>;
+template <typename Policy>
+constexpr bool isUnseq = std::is_same_v<Policy, ParallelUnsequencedPolicy>;
+
+template <typename It>
+using ValueOf = typename std::iterator_traits<It>::value_type;
+
+// How [0, n) gets split: chunk size, number of chunks, and the pool to run them on
+struct Chunking {
+	ThreadPool *pool;
+	unsigned threads;
+	size_t chunk, count;
+
+	bool serial() const { return count <= 1; }
+
+	// fn(begin, end) for every chunk
+	template <typename F>
+	void run(size_t n, F &&fn) const { pool->parallelFor(n, chunk, fn, threads); }
+};
+
+inline Chunking chunking(const ParallelPolicy &policy, size_t n)
+{
+	ThreadPool &pool = policy.cfg.pool ? *policy.cfg.pool : ThreadPool::global();
+	unsigned threads = policy.cfg.threads ? policy.cfg.threads : pool.workers() + 1;
+	size_t chunk = std::max(n / (threads * 4) + 1, policy.grain ? policy.grain : defaultGrain); // a few chunks per thread evens out the load
+	size_t count = threads <= 1 || pool.workers() == 0 ? 1 : (n + chunk - 1) / chunk;
+	if (count <= 1)
+		chunk = std::max<size_t>(n, 1);
+	return { &pool, threads, chunk, count };
+}
+
+// f(i) for i in [begin, end), as an independent-iterations loop for par_unseq
+template <bool Unseq, typename F>
+void forEachIndex(size_t begin, size_t end, F &&f)
+{
+	if constexpr (Unseq) {
+		ALGO_IVDEP
+		for (size_t i = begin; i < end; i++)
+			f(i);
+	} else {
+		for (size_t i = begin; i < end; i++)
+			f(i);
+	}
+}
+
+// Lowers target to value if that's smaller
+inline void storeMin(std::atomic<size_t> &target, size_t value)
+{
+	size_t cur = target.load(std::memory_order_relaxed);
+	while (value < cur && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+	}
+}
+
+// A piece of a pair of sorted ranges that can be merged (or set-operated on) on its own: a[a, a + na) with b[b, b + nb), merged it goes to out
+struct Piece {
+	size_t a, na, b, nb, out;
+};
+
+// Cuts sorted a[0, na) and b[0, nb) into at most pieces pieces. Cuts are at values, both ranges are cut at the first element not less than
+// the value, so all elements that compare equal (in both ranges) end up in the same piece: merging the pieces one by one gives what one
+// std::merge gives, equal elements of a before those of b included. The cut values are taken from the longer range, so pieces are about even
+template <typename ItA, typename ItB, typename Comp>
+std::vector<Piece> cutSorted(ItA a, size_t na, ItB b, size_t nb, size_t pieces, Comp comp)
+{
+	std::vector<Piece> out;
+	size_t prevA = 0, prevB = 0;
+	for (size_t k = 1; k <= pieces; k++) {
+		size_t ca = na, cb = nb;
+		if (k < pieces) {
+			auto cutAt = [&](const auto &v) {
+				ca = static_cast<size_t>(std::lower_bound(a + prevA, a + na, v, comp) - a);
+				cb = static_cast<size_t>(std::lower_bound(b + prevB, b + nb, v, comp) - b);
+			};
+			if (na >= nb)
+				cutAt(a[na * k / pieces]);
+			else
+				cutAt(b[nb * k / pieces]);
+		}
+		if (ca > prevA || cb > prevB)
+			out.push_back({ prevA, ca - prevA, prevB, cb - prevB, prevA + prevB });
+		prevA = ca;
+		prevB = cb;
+	}
+	return out;
+}
+
+inline size_t pieceCount(const Chunking &c) { return std::max<size_t>(c.count, 1); }
+
+// Merges pieces in parallel into out + piece.out. Move = move the elements out of a and b instead of copying
+template <bool Move, typename ItA, typename ItB, typename Out, typename Comp>
+void mergePieces(const Chunking &c, const std::vector<Piece> &pieces, ItA a, ItB b, Out out, Comp comp)
+{
+	c.pool->parallelFor(pieces.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const Piece &p = pieces[i];
+			if constexpr (Move)
+				std::merge(std::make_move_iterator(a + p.a), std::make_move_iterator(a + p.a + p.na), std::make_move_iterator(b + p.b),
+					std::make_move_iterator(b + p.b + p.nb), out + p.out, comp);
+			else
+				std::merge(a + p.a, a + p.a + p.na, b + p.b, b + p.b + p.nb, out + p.out, comp);
+		}
+	}, c.threads);
+}
+
+// Sorts the chunks in parallel, then merges them pairwise, back and forth between the range and a buffer. Every round cuts all of its
+// merges into pieces (cutSorted), so even the last merge of two halves runs on all threads
+template <bool Stable, typename It, typename Comp>
+void mergeSort(const ParallelPolicy &policy, It first, It last, Comp comp)
+{
+	size_t n = static_cast<size_t>(last - first);
+	Chunking c = chunking(policy, n);
+	if (c.serial()) {
+		if constexpr (Stable)
+			std::stable_sort(first, last, comp);
+		else
+			std::sort(first, last, comp);
+		return;
+	}
+	c.run(n, [&](size_t begin, size_t end) {
+		if constexpr (Stable)
+			std::stable_sort(first + begin, first + end, comp);
+		else
+			std::sort(first + begin, first + end, comp);
+	});
+
+	std::vector<ValueOf<It>> buffer(n);
+	bool inBuffer = false;
+	auto round = [&](auto src, auto dst, size_t width) {
+		std::vector<Piece> pieces;
+		for (size_t start = 0; start < n; start += 2 * width) {
+			size_t mid = std::min(start + width, n), end = std::min(start + 2 * width, n);
+			// a run without a partner (odd count) is a piece with an empty b
+			size_t share = std::max<size_t>(pieceCount(c) * (end - start) / n, 1);
+			for (Piece p : cutSorted(src + start, mid - start, src + mid, end - mid, share, comp)) {
+				p.a += start;
+				p.b += mid;
+				p.out += start;
+				pieces.push_back(p);
+			}
+		}
+		mergePieces<true>(c, pieces, src, src, dst, comp);
+	};
+	for (size_t width = c.chunk; width < n; width *= 2) {
+		if (inBuffer)
+			round(buffer.begin(), first, width);
+		else
+			round(first, buffer.begin(), width);
+		inBuffer = !inBuffer;
+	}
+	if (inBuffer)
+		c.run(n, [&](size_t begin, size_t end) { std::move(buffer.begin() + begin, buffer.begin() + end, first + begin); });
+}
+
+// The four set operations: cut both ranges (cutSorted keeps equal elements together, which is what the multiset semantics of the std
+// versions need), run op on every piece into its own vector, then copy the pieces out one after the other
+template <typename ItA, typename ItB, typename Out, typename Comp, typename Op>
+Out setOperation(SequencedPolicy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp, Op op) { return op(a, aLast, b, bLast, out, comp); }
+
+template <typename ItA, typename ItB, typename Out, typename Comp, typename Op>
+Out setOperation(const ParallelPolicy &policy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp, Op op)
+{
+	size_t na = static_cast<size_t>(aLast - a), nb = static_cast<size_t>(bLast - b);
+	Chunking c = chunking(policy, na + nb);
+	if (c.serial())
+		return op(a, aLast, b, bLast, out, comp);
+	std::vector<Piece> pieces = cutSorted(a, na, b, nb, pieceCount(c), comp);
+	std::vector<std::vector<ValueOf<ItA>>> results(pieces.size());
+	c.pool->parallelFor(pieces.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const Piece &p = pieces[i];
+			op(a + p.a, a + p.a + p.na, b + p.b, b + p.b + p.nb, std::back_inserter(results[i]), comp);
+		}
+	}, c.threads);
+	std::vector<size_t> offsets(results.size() + 1, 0);
+	for (size_t i = 0; i < results.size(); i++)
+		offsets[i + 1] = offsets[i] + results[i].size();
+	c.pool->parallelFor(results.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			std::move(results[i].begin(), results[i].end(), out + offsets[i]);
+	}, c.threads);
+	return out + offsets.back();
+}
+
+} // namespace detail
+
+// Non-modifying
+
+template <typename Policy, typename It, typename F>
+void for_each(const Policy &policy, It first, It last, F f)
+{
+	if constexpr (detail::isSeq<Policy>) {
+		std::for_each(first, last, f);
+	} else {
+		size_t n = static_cast<size_t>(last - first);
+		detail::chunking(policy, n).run(n, [&](size_t begin, size_t end) { detail::forEachIndex<detail::isUnseq<Policy>>(begin, end, [&](size_t i) { f(first[i]); }); });
+	}
+}
+
+template <typename Policy, typename It, typename Pred>
+size_t count_if(const Policy &policy, It first, It last, Pred pred)
+{
+	if constexpr (detail::isSeq<Policy>) {
+		return static_cast<size_t>(std::count_if(first, last, pred));
+	} else {
+		size_t n = static_cast<size_t>(last - first);
+		std::atomic<size_t> total { 0 };
+		detail::chunking(policy, n).run(n, [&](size_t begin, size_t end) {
+			size_t count = 0;
+			detail::forEachIndex<detail::isUnseq<Policy>>(begin, end, [&](size_t i) { count += pred(first[i]) ? 1 : 0; });
+			total += count;
+		});
+		return total;
+	}
+}
+
+template <typename Policy, typename It, typename T>
+size_t count(const Policy &policy, It first, It last, const T &value)
+{
+	return count_if(policy, first, last, [&](const auto &x) { return x == value; });
+}
+
+// The first match, like std::find_if. Chunks look at the lowest match found so far every few hundred elements and give up when it's
+// in front of them, so a match near the start doesn't mean scanning the whole range anyway
+template <typename Policy, typename It, typename Pred>
+It find_if(const Policy &policy, It first, It last, Pred pred)
+{
+	if constexpr (detail::isSeq<Policy>) {
+		return std::find_if(first, last, pred);
+	} else {
+		const size_t block = 256;
+		size_t n = static_cast<size_t>(last - first);
+		std::atomic<size_t> found { n };
+		detail::chunking(policy, n).run(n, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i += block) {
+				if (found.load(std::memory_order_relaxed) < i)
+					return;
+				for (size_t j = i, stop = std::min(end, i + block); j < stop; j++) {
+					if (pred(first[j])) {
+						detail::storeMin(found, j);
+						return;
+					}
+				}
+			}
+		});
+		return first + found.load();
+	}
+}
+
+template <typename Policy, typename It, typename T>
+It find(const Policy &policy, It first, It last, const T &value)
+{
+	return find_if(policy, first, last, [&](const auto &x) { return x == value; });
+}
+
+template <typename Policy, typename It, typename Pred>
+bool any_of(const Policy &policy, It first, It last, Pred pred) { return find_if(policy, first, last, pred) != last; }
+template <typename Policy, typename It, typename Pred>
+bool none_of(const Policy &policy, It first, It last, Pred pred) { return !any_of(policy, first, last, pred); }
+template <typename Policy, typename It, typename Pred>
+bool all_of(const Policy &policy, It first, It last, Pred pred)
+{
+	return !any_of(policy, first, last, [&](const auto &x) { return !pred(x); });
+}
+
+// Modifying
+
+template <typename Policy, typename It, typename Out, typename Op>
+Out transform(const Policy &policy, It first, It last, Out out, Op op)
+{
+	if constexpr (detail::isSeq<Policy>) {
+		return std::transform(first, last, out, op);
+	} else {
+		size_t n = static_cast<size_t>(last - first);
+		detail::chunking(policy, n).run(n, [&](size_t begin, size_t end) { detail::forEachIndex<detail::isUnseq<Policy>>(begin, end, [&](size_t i) { out[i] = op(first[i]); }); });
+		return out + n;
+	}
+}
+
+// Reduction (for buffers of arithmetic types fold::reduce in reduce.h is faster, it vectorizes the accumulation)
+
+template <typename Policy, typename It, typename T, typename Op = std::plus<>>
+T reduce(const Policy &policy, It first, It last, T init, Op op = {})
+{
+	if constexpr (detail::isSeq<Policy>) {
+		return std::accumulate(first, last, init, op);
+	} else {
+		size_t n = static_cast<size_t>(last - first);
+		detail::Chunking c = detail::chunking(policy, n);
+		if (c.serial())
+			return std::accumulate(first, last, init, op);
+		std::vector<T> partial(c.count);
+		c.run(n, [&](size_t begin, size_t end) {
+			T acc = first[begin];
+			for (size_t i = begin + 1; i < end; i++)
+				acc = op(acc, first[i]);
+			partial[begin / c.chunk] = acc;
+		});
+		for (auto &x : partial) // in chunk order, so it doesn't matter which thread finished first
+			init = op(init, x);
+		return init;
+	}
+}
+
+// Prefix sums. Two passes over the chunks: every chunk's total, then (after adding up the totals before each chunk serially) every chunk
+// scans again starting from its carry. out may be first (in place)
+
+namespace detail {
+
+template <typename It, typename Out, typename T, typename Op>
+Out scan(const ParallelPolicy &policy, It first, It last, Out out, const T *init, Op op, bool inclusive)
+{
+	size_t n = static_cast<size_t>(last - first);
+	Chunking c = chunking(policy, n);
+	if (c.serial()) {
+		if (inclusive)
+			return init ? std::inclusive_scan(first, last, out, op, *init) : std::inclusive_scan(first, last, out, op);
+		return std::exclusive_scan(first, last, out, *init, op);
+	}
+	std::vector<T> totals(c.count);
+	c.run(n, [&](size_t begin, size_t end) {
+		T acc = first[begin];
+		for (size_t i = begin + 1; i < end; i++)
+			acc = op(acc, first[i]);
+		totals[begin / c.chunk] = acc;
+	});
+	// carry[k] = init op total[0] op ... op total[k - 1], chunk 0 of an inclusive scan without init has none
+	std::vector<T> carry(c.count);
+	bool carried = init != nullptr;
+	if (carried)
+		carry[0] = *init;
+	for (size_t k = 1; k < c.count; k++)
+		carry[k] = k == 1 && !carried ? totals[0] : op(carry[k - 1], totals[k - 1]);
+	c.run(n, [&](size_t begin, size_t end) {
+		size_t k = begin / c.chunk;
+		if (inclusive) {
+			size_t i = begin;
+			T acc = k > 0 || carried ? op(carry[k], first[i]) : T(first[i]);
+			out[i] = acc;
+			for (i++; i < end; i++) {
+				acc = op(acc, first[i]);
+				out[i] = acc;
+			}
+		} else {
+			T acc = carry[k];
+			for (size_t i = begin; i < end; i++) {
+				T next = op(acc, first[i]); // read before writing, out may be first
+				out[i] = acc;
+				acc = next;
+			}
+		}
+	});
+	return out + n;
+}
+
+} // namespace detail
+
+template <typename Policy, typename It, typename Out, typename Op = std::plus<>>
+Out inclusive_scan(const Policy &policy, It first, It last, Out out, Op op = {})
+{
+	if constexpr (detail::isSeq<Policy>)
+		return std::inclusive_scan(first, last, out, op);
+	else
+		return detail::scan<It, Out, detail::ValueOf<It>>(policy, first, last, out, nullptr, op, true);
+}
+
+// With init, the sums are accumulated in init's type (which can be wider than the elements)
+template <typename Policy, typename It, typename Out, typename Op, typename T>
+Out inclusive_scan(const Policy &policy, It first, It last, Out out, Op op, T init)
+{
+	if constexpr (detail::isSeq<Policy>)
+		return std::inclusive_scan(first, last, out, op, init);
+	else
+		return detail::scan(policy, first, last, out, &init, op, true);
+}
+
+template <typename Policy, typename It, typename Out, typename T, typename Op = std::plus<>>
+Out exclusive_scan(const Policy &policy, It first, It last, Out out, T init, Op op = {})
+{
+	if constexpr (detail::isSeq<Policy>)
+		return std::exclusive_scan(first, last, out, init, op);
+	else
+		return detail::scan(policy, first, last, out, &init, op, false);
+}
+
+// Sorting
+
+template <typename Policy, typename It, typename Comp = std::less<>>
+void sort(const Policy &policy, It first, It last, Comp comp = {})
+{
+	if constexpr (detail::isSeq<Policy>)
+		std::sort(first, last, comp);
+	else
+		detail::mergeSort<false>(policy, first, last, comp);
+}
+
+template <typename Policy, typename It, typename Comp = std::less<>>
+void stable_sort(const Policy &policy, It first, It last, Comp comp = {})
+{
+	if constexpr (detail::isSeq<Policy>)
+		std::stable_sort(first, last, comp);
+	else
+		detail::mergeSort<true>(policy, first, last, comp);
+}
+
+// Sorted ranges
+
+template <typename Policy, typename ItA, typename ItB, typename Out, typename Comp = std::less<>>
+Out merge(const Policy &policy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp = {})
+{
+	if constexpr (detail::isSeq<Policy>) {
+		return std::merge(a, aLast, b, bLast, out, comp);
+	} else {
+		size_t na = static_cast<size_t>(aLast - a), nb = static_cast<size_t>(bLast - b);
+		detail::Chunking c = detail::chunking(policy, na + nb);
+		if (c.serial())
+			return std::merge(a, aLast, b, bLast, out, comp);
+		detail::mergePieces<false>(c, detail::cutSorted(a, na, b, nb, detail::pieceCount(c), comp), a, b, out, comp);
+		return out + na + nb;
+	}
+}
+
+template <typename Policy, typename ItA, typename ItB, typename Out, typename Comp = std::less<>>
+Out set_union(const Policy &policy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp = {})
+{
+	return detail::setOperation(policy, a, aLast, b, bLast, out, comp, [](auto... args) { return std::set_union(args...); });
+}
+
+template <typename Policy, typename ItA, typename ItB, typename Out, typename Comp = std::less<>>
+Out set_intersection(const Policy &policy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp = {})
+{
+	return detail::setOperation(policy, a, aLast, b, bLast, out, comp, [](auto... args) { return std::set_intersection(args...); });
+}
+
+template <typename Policy, typename ItA, typename ItB, typename Out, typename Comp = std::less<>>
+Out set_difference(const Policy &policy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp = {})
+{
+	return detail::setOperation(policy, a, aLast, b, bLast, out, comp, [](auto... args) { return std::set_difference(args...); });
+}
+
+template <typename Policy, typename ItA, typename ItB, typename Out, typename Comp = std::less<>>
+Out set_symmetric_difference(const Policy &policy, ItA a, ItA aLast, ItB b, ItB bLast, Out out, Comp comp = {})
+{
+	return detail::setOperation(policy, a, aLast, b, bLast, out, comp, [](auto... args) { return std::set_symmetric_difference(args...); });
+}
+
+} // namespace algo
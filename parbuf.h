@@ -0,0 +1,102 @@
+#pragma once
+
+// Multithreaded fill/generate/transform for big buffers, on the persistent ThreadPool (threadpool.h) instead of std::execution::par.
+// The buffer is split in chunks whose boundaries fall on cache lines (64 bytes), so two threads never write the same line (no false sharing).
+//
+// Position dependent generators have to know where their chunk starts, so generate takes a factory that makes a generator for a given start index:
+//
+//	par::generate(p, size, [](size_t start) { return [i = start]() mutable { return (i++) % 256; }; });	// same output as the serial std::generate
+//	par::generateIndexed(p, size, [](size_t i) { return i % 256; });
+//
+// threads = 0 means the caller plus every worker of the pool, otherwise at most that many threads (for scaling benchmarks).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "fill.h"
+#include "threadpool.h"
+
+namespace par {
+
+constexpr size_t cacheLine = 64;
+constexpr size_t minChunkBytes = 64 * 1024; // smaller chunks cost more in scheduling than they gain
+
+struct Config {
+	ThreadPool *pool = nullptr;	// nullptr = ThreadPool::global()
+	unsigned threads = 0;
+};
+
+// Calls fn(begin, end) (element indexes into dst) on chunks whose start addresses are cache line aligned (except the first, which starts at dst)
+template <typename T, typename F>
+void forChunks(T *dst, size_t n, F fn, Config cfg = {})
+{
+	ThreadPool &pool = cfg.pool ? *cfg.pool : ThreadPool::global();
+	unsigned threads = cfg.threads ? cfg.threads : pool.workers() + 1;
+
+	// Work in a "virtual" index space that starts at the cache line before dst, then every chunk boundary that is a multiple of
+	// a cache line in that space is aligned in memory as well. Only works when T divides a cache line, otherwise chunks are just unaligned.
+	size_t lineElems = cacheLine % sizeof(T) == 0 ? cacheLine / sizeof(T) : 1;
+	size_t head = (reinterpret_cast<uintptr_t>(dst) % cacheLine) / sizeof(T);
+	if (lineElems == 1)
+		head = 0;
+
+	size_t total = n + head;
+	size_t chunk = std::max(total / (threads * 4) + 1, minChunkBytes / sizeof(T)); // a few chunks per thread evens out load differences
+	chunk = (chunk + lineElems - 1) / lineElems * lineElems;
+
+	pool.parallelFor(total, chunk, [&](size_t vBegin, size_t vEnd) {
+		size_t begin = vBegin > head ? vBegin - head : 0;
+		size_t end = vEnd > head ? vEnd - head : 0;
+		if (begin < end)
+			fn(begin, end);
+	}, threads);
+}
+
+inline void fill(void *dst, uint8_t value, size_t n, Config cfg = {}, buf::Store store = buf::Store::Auto)
+{
+	auto *d = static_cast<uint8_t *>(dst);
+	// the streaming decision is for the whole buffer, not per chunk
+	buf::Store chunkStore = buf::useStreaming(n, store) ? buf::Store::NonTemporal : buf::Store::Temporal;
+	forChunks(d, n, [&](size_t begin, size_t end) { buf::fillConst(d + begin, value, end - begin, buf::kernels(), chunkStore); }, cfg);
+}
+
+// dst[i] = (start + i) % 256, the ramp kernel just needs its chunk's first value
+inline void fillRamp(void *dst, size_t n, uint8_t start = 0, Config cfg = {}, buf::Store store = buf::Store::Auto)
+{
+	auto *d = static_cast<uint8_t *>(dst);
+	buf::Store chunkStore = buf::useStreaming(n, store) ? buf::Store::NonTemporal : buf::Store::Temporal;
+	forChunks(d, n, [&](size_t begin, size_t end) { buf::fillRamp(d + begin, end - begin, static_cast<uint8_t>(start + begin), buf::kernels(), chunkStore); }, cfg);
+}
+
+// dst[i] = gen(i)
+template <typename T, typename Gen>
+void generateIndexed(T *dst, size_t n, Gen gen, Config cfg = {})
+{
+	forChunks(dst, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			dst[i] = gen(i);
+	}, cfg);
+}
+
+// makeGen(start) returns a (stateful) generator that produces the values from index start on, each chunk gets its own
+template <typename T, typename MakeGen>
+void generate(T *dst, size_t n, MakeGen makeGen, Config cfg = {})
+{
+	forChunks(dst, n, [&](size_t begin, size_t end) {
+		auto gen = makeGen(begin);
+		std::generate(dst + begin, dst + end, gen);
+	}, cfg);
+}
+
+// dst[i] = op(src[i]), chunks are aligned on dst (the side we write)
+template <typename In, typename Out, typename Op>
+void transform(const In *src, Out *dst, size_t n, Op op, Config cfg = {})
+{
+	forChunks(dst, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			dst[i] = op(src[i]);
+	}, cfg);
+}
+
+} // namespace par
@@ -0,0 +1,155 @@
+#pragma once
+
+// Hardware performance counters around a benchmark body, through Linux perf_event_open (the same counters "perf stat" shows), so a
+// result comes with why it is as fast as it is: instructions per cycle, bytes per cycle, cache, TLB and branch misses, page faults.
+//
+//	bench::PerfCounters pc;
+//	if (pc.available()) { pc.start(); work(); pc.stop(); auto c = pc.read(); ... c.ipc() ... }
+//
+// Every counter is opened on its own, so a cpu/vm that lacks one still gets the others (a VM often exposes no PMU at all, then only the
+// software page fault counter works). Nothing available (not Linux, perf_event_paranoid too high, seccomp) just means available() is false.
+// Counts are for the calling thread, plus threads it creates while counting; work on already running pool threads is not counted.
+// User space only (exclude_kernel), which also makes them usable with perf_event_paranoid = 2, the default.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+// -1 means the counter isn't available here
+struct CounterValues {
+	double cycles = -1, instructions = -1, cacheMisses = -1, branchMisses = -1, llcLoads = -1, dtlbMisses = -1, pageFaults = -1;
+
+	double ipc() const { return cycles > 0 && instructions >= 0 ? instructions / cycles : -1; }
+	double bytesPerCycle(size_t bytes) const { return cycles > 0 && bytes ? bytes / cycles : -1; }
+};
+
+// For going over all of them (summing, averaging)
+inline constexpr double CounterValues::*counterFields[] = { &CounterValues::cycles, &CounterValues::instructions, &CounterValues::cacheMisses,
+	&CounterValues::branchMisses, &CounterValues::llcLoads, &CounterValues::dtlbMisses, &CounterValues::pageFaults };
+
+class PerfCounters {
+public:
+	enum Event { Cycles, Instructions, CacheMisses, BranchMisses, LlcLoads, DtlbMisses, PageFaults, EventCount };
+
+	PerfCounters()
+	{
+#if defined(__linux__)
+		open(Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		open(CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+		open(BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+		open(LlcLoads, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16));
+		open(DtlbMisses, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+		open(PageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+#endif
+	}
+
+	~PerfCounters()
+	{
+#if defined(__linux__)
+		for (int fd : fds)
+			if (fd >= 0)
+				close(fd);
+#endif
+	}
+
+	PerfCounters(const PerfCounters &) = delete;
+	PerfCounters &operator=(const PerfCounters &) = delete;
+
+	bool available() const
+	{
+		for (int fd : fds)
+			if (fd >= 0)
+				return true;
+		return false;
+	}
+	bool hardware() const { return fds[Cycles] >= 0; }	// false when only the software counters work
+
+	// Zero and start all counters
+	void start()
+	{
+#if defined(__linux__)
+		for (int fd : fds) {
+			if (fd >= 0) {
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+#endif
+	}
+
+	void stop()
+	{
+#if defined(__linux__)
+		for (int fd : fds)
+			if (fd >= 0)
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+	}
+
+	// Counts since start(). When there are more counters than the PMU has registers the kernel time-shares them, the counts are scaled
+	// up by enabled/running time then (estimates)
+	CounterValues read() const
+	{
+		double v[EventCount];
+		for (int e = 0; e < EventCount; e++)
+			v[e] = value(e);
+		CounterValues c;
+		c.cycles = v[Cycles];
+		c.instructions = v[Instructions];
+		c.cacheMisses = v[CacheMisses];
+		c.branchMisses = v[BranchMisses];
+		c.llcLoads = v[LlcLoads];
+		c.dtlbMisses = v[DtlbMisses];
+		c.pageFaults = v[PageFaults];
+		return c;
+	}
+
+private:
+#if defined(__linux__)
+	void open(Event e, uint32_t type, uint64_t config)
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.inherit = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		fds[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0)); // this thread, any cpu, no group
+	}
+#endif
+
+	double value(int e) const
+	{
+#if defined(__linux__)
+		if (fds[e] < 0)
+			return -1;
+		uint64_t data[3] = {}; // value, time enabled, time running
+		if (::read(fds[e], data, sizeof(data)) != sizeof(data))
+			return -1;
+		if (data[2] == 0)
+			return data[1] == 0 ? 0 : -1; // never got a register while enabled, no estimate possible
+		return data[0] * (static_cast<double>(data[1]) / data[2]);
+#else
+		(void)e;
+		return -1;
+#endif
+	}
+
+	int fds[EventCount] = { -1, -1, -1, -1, -1, -1, -1 };
+};
+
+} // namespace bench
@@ -0,0 +1,153 @@
+#pragma once
+
+// FoldPrint without iostreams: every argument is formatted with std::to_chars (no locale, no stream state, no allocation) into a fixed
+// buffer that belongs to the calling thread, and the buffer goes out with one write(2).
+//
+//	out::print("Hello ", "Mr ", 242, '!');		// same arguments and same output as FoldPrint, including the "\n"
+//	out::local().setMode(out::Mode::Batch);		// this thread: write only when the buffer is full (or on flush(), or when the thread ends)
+//	out::flush();
+//
+// Lines are never split between writes (as long as one fits in the buffer), and a single write is not interleaved with other threads' writes,
+// so lines from different threads come out whole. Line mode is the default, like a terminal. Anything printed with cout/printf before is
+// flushed first (they buffer in stdout), so the order between the two is kept.
+// Numbers look the same as with cout's defaults: integers in decimal, floating point like %g (6 significant digits).
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(_WIN32)
+#include <io.h>	// _write
+#else
+#include <unistd.h>	// write
+#endif
+
+namespace out {
+
+enum class Mode { Line, Batch };
+
+class Writer {
+public:
+	static constexpr size_t capacity = 4096;
+
+	explicit Writer(int fd = 1, Mode mode = Mode::Line) : fd(fd), mode(mode) {}
+	~Writer() { flush(); }
+
+	Writer(const Writer &) = delete;
+	Writer &operator=(const Writer &) = delete;
+
+	void setMode(Mode m)
+	{
+		flush();
+		mode = m;
+	}
+
+	template <typename... T>
+	void print(const T &... args)
+	{
+		size_t lineStart = len;
+		(put(args), ...);
+		put('\n');
+		if (overflowed) { // the line didn't fit behind what was already there: write out the complete lines, then this one on its own
+			overflowed = false;
+			len = lineStart;
+			flush();
+			splitting = true; // if it doesn't fit now it's longer than the whole buffer, and gets written in pieces
+			(put(args), ...);
+			put('\n');
+			splitting = false;
+		}
+		if (mode == Mode::Line)
+			flush();
+	}
+
+	void flush()
+	{
+		if (len == 0)
+			return;
+		if (fd == 1)
+			std::fflush(stdout); // whatever cout/printf still hold goes first
+		const char *p = buf;
+		size_t left = len;
+		while (left > 0) {
+#if defined(_WIN32)
+			int w = _write(fd, p, static_cast<unsigned>(left));
+#else
+			ssize_t w = ::write(fd, p, left);
+#endif
+			if (w <= 0)
+				break; // nowhere to report it, same as cout setting badbit
+			p += w;
+			left -= static_cast<size_t>(w);
+		}
+		len = 0;
+	}
+
+private:
+	void append(const char *s, size_t n)
+	{
+		while (len + n > capacity) {
+			if (!splitting) { // print() writes out the earlier lines and starts this one over
+				overflowed = true;
+				return;
+			}
+			size_t part = capacity - len;
+			std::memcpy(buf + len, s, part);
+			len = capacity;
+			flush();
+			s += part;
+			n -= part;
+		}
+		std::memcpy(buf + len, s, n);
+		len += n;
+	}
+
+	template <typename T>
+	void put(const T &v)
+	{
+		if (overflowed)
+			return;
+		if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+			append(reinterpret_cast<const char *>(&v), 1); // cout prints all three as characters
+		} else if constexpr (std::is_same_v<T, bool>) {
+			append(v ? "1" : "0", 1); // cout prints bools as numbers too (without boolalpha)
+		} else if constexpr (std::is_integral_v<T>) {
+			char tmp[24];
+			append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), v).ptr - tmp);
+		} else if constexpr (std::is_floating_point_v<T>) {
+			char tmp[32];
+#if defined(__cpp_lib_to_chars)
+			append(tmp, std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::general, 6).ptr - tmp);
+#else
+			append(tmp, std::snprintf(tmp, sizeof(tmp), "%g", static_cast<double>(v)));
+#endif
+		} else {
+			std::string_view s(v); // strings, string literals, char pointers
+			append(s.data(), s.size());
+		}
+	}
+
+	int fd;
+	Mode mode;
+	size_t len = 0;
+	bool overflowed = false, splitting = false;
+	char buf[capacity];
+};
+
+// The calling thread's writer for stdout, flushed when the thread ends
+inline Writer &local()
+{
+	static thread_local Writer w;
+	return w;
+}
+
+template <typename... T>
+void print(const T &... args) { local().print(args...); }
+
+inline void flush() { local().flush(); }
+
+} // namespace out
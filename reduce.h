@@ -0,0 +1,255 @@
+#pragma once
+
+// Reductions over runtime ranges with the same operators the sum() fold expression in main() uses on a parameter pack.
+//
+//	fold::of(fold::Max{}, 3, 9, 4);										// 9, compile time pack like sum(), any operator
+//	fold::reduce<uint64_t>(p, n, fold::Plus{});							// sum of n bytes, accumulated in 64 bits
+//	fold::reduce<uint64_t>(fold::parallel, p, n, fold::Plus{});			// same on the thread pool
+//	fold::sumKahan(f, n); fold::sumPairwise(f, n);						// floating point sums that don't lose the small terms
+//
+// A plain  for (...) acc = acc + p[i]  is one long dependency chain: every add waits for the previous one, and the compiler may not
+// reorder float adds to vectorize it. Here every range is reduced into a block of independent accumulators ("lanes", 256 bytes worth)
+// that are only combined at the end, so the adds pipeline and the lanes map straight onto SSE2/AVX2/AVX-512 registers. The kernel is
+// compiled for each isa (same target attributes and runtime dispatch as fill.h) and the best one for this cpu is picked once.
+// For floats that changes the order of the adds compared to the serial loop, so the result can differ in the last bits (it's usually
+// more accurate, not less). Use sumKahan/sumPairwise when that matters.
+//
+// Acc is the type accumulated (and returned) in, so byte buffers can be summed without overflowing. Ops must be associative and commutative.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "fill.h"
+#include "parbuf.h"
+#include "threadpool.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FOLD_INLINE __attribute__((always_inline)) inline	// the generic kernel has to be inlined into each isa wrapper to get that isa's code
+#elif defined(_MSC_VER)
+#define FOLD_INLINE __forceinline
+#else
+#define FOLD_INLINE inline
+#endif
+
+namespace fold {
+
+// The operators, each with the value that doesn't change a result (what an empty range reduces to)
+struct Plus {
+	template <typename T> static constexpr T identity() { return T(0); }
+	template <typename T> constexpr T operator()(T a, T b) const { return a + b; }
+};
+struct Multiplies {
+	template <typename T> static constexpr T identity() { return T(1); }
+	template <typename T> constexpr T operator()(T a, T b) const { return a * b; }
+};
+struct Min {
+	template <typename T> static constexpr T identity() { return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max(); }
+	template <typename T> constexpr T operator()(T a, T b) const { return b < a ? b : a; }
+};
+struct Max {
+	template <typename T> static constexpr T identity() { return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest(); }
+	template <typename T> constexpr T operator()(T a, T b) const { return a < b ? b : a; }
+};
+struct BitAnd {
+	template <typename T> static constexpr T identity() { return static_cast<T>(~T(0)); }
+	template <typename T> constexpr T operator()(T a, T b) const { return a & b; }
+};
+struct BitOr {
+	template <typename T> static constexpr T identity() { return T(0); }
+	template <typename T> constexpr T operator()(T a, T b) const { return a | b; }
+};
+struct BitXor {
+	template <typename T> static constexpr T identity() { return T(0); }
+	template <typename T> constexpr T operator()(T a, T b) const { return a ^ b; }
+};
+
+// sum(args...) for any operator: (((a op b) op c) op ...), a fold over the comma operator since a fold can only use built-in operators
+template <typename Op, typename T, typename... Rest>
+constexpr T of(Op op, T first, Rest... rest)
+{
+	T r = first;
+	((r = op(r, static_cast<T>(rest))), ...);
+	return r;
+}
+
+// Execution policies, like std::execution::seq/par (which this libstdc++ can't use without TBB)
+struct Sequenced {};
+struct Parallel {
+	par::Config cfg;
+};
+inline constexpr Sequenced seq {};
+inline constexpr Parallel parallel {};
+
+namespace detail {
+
+template <typename Acc>
+constexpr size_t lanes = std::max<size_t>(256 / sizeof(Acc), 1);
+
+// Sum of 8/16 bit integers into a wide Acc. Widening every element to 64 bits makes a vector hold 8 times fewer of them, so the
+// lanes are a type just wide enough to hold a block's sums without overflowing, and only the lanes are widened, once per block.
+template <typename Acc, typename T>
+FOLD_INLINE Acc sumWidening(const T *p, size_t n)
+{
+	using Mid = std::conditional_t<sizeof(T) == 1, std::conditional_t<std::is_signed_v<T>, int16_t, uint16_t>, std::conditional_t<std::is_signed_v<T>, int32_t, uint32_t>>;
+	constexpr size_t L = lanes<Mid>;
+	constexpr size_t rounds = std::numeric_limits<Mid>::max() / std::max<size_t>(std::numeric_limits<T>::max(), size_t(0) - std::numeric_limits<T>::min());
+	Acc total = 0;
+	size_t i = 0;
+	while (i + L <= n) {
+		Mid acc[L] = {};
+		size_t end = i + std::min((n - i) / L, rounds) * L;
+		for (; i < end; i += L)
+			for (size_t j = 0; j < L; j++)
+				acc[j] += p[i + j];
+		for (size_t j = 0; j < L; j++)
+			total += acc[j];
+	}
+	for (; i < n; i++)
+		total += p[i];
+	return total;
+}
+
+// The actual reduction: lanes independent accumulators, lane j takes elements j, j + lanes, j + 2 * lanes, ...
+template <typename Acc, typename T, typename Op>
+FOLD_INLINE Acc reduceLanes(const T *p, size_t n, Op op)
+{
+	if constexpr (std::is_same_v<Op, Plus> && std::is_integral_v<T> && std::is_integral_v<Acc> && sizeof(T) <= 2 && sizeof(Acc) > 2 * sizeof(T))
+		return sumWidening<Acc>(p, n);
+	constexpr size_t L = lanes<Acc>;
+	Acc acc[L];
+	for (size_t j = 0; j < L; j++)
+		acc[j] = Op::template identity<Acc>();
+	size_t i = 0;
+	for (; i + L <= n; i += L)
+		for (size_t j = 0; j < L; j++)
+			acc[j] = op(acc[j], static_cast<Acc>(p[i + j]));
+	for (size_t j = 0; i < n; i++, j++)
+		acc[j] = op(acc[j], static_cast<Acc>(p[i]));
+	for (size_t w = L / 2; w > 0; w /= 2) // combine the lanes as a tree, half of them onto the other half
+		for (size_t j = 0; j < w; j++)
+			acc[j] = op(acc[j], acc[j + w]);
+	return acc[0];
+}
+
+template <typename Acc, typename T, typename Op>
+Acc reduceScalar(const T *p, size_t n, Op op) { return reduceLanes<Acc>(p, n, op); }
+#if defined(BUF_X86)
+template <typename Acc, typename T, typename Op>
+BUF_TARGET("sse2") Acc reduceSSE2(const T *p, size_t n, Op op) { return reduceLanes<Acc>(p, n, op); }
+template <typename Acc, typename T, typename Op>
+BUF_TARGET("avx2") Acc reduceAVX2(const T *p, size_t n, Op op) { return reduceLanes<Acc>(p, n, op); }
+template <typename Acc, typename T, typename Op>
+BUF_TARGET("avx512f,avx512bw") Acc reduceAVX512(const T *p, size_t n, Op op) { return reduceLanes<Acc>(p, n, op); }
+#endif
+
+template <typename Acc, typename T, typename Op>
+using Kernel = Acc (*)(const T *, size_t, Op);
+
+template <typename Acc, typename T, typename Op>
+Kernel<Acc, T, Op> kernelFor(buf::Isa isa)
+{
+	switch (isa) {
+#if defined(BUF_X86)
+	case buf::Isa::SSE2: return reduceSSE2<Acc, T, Op>;
+	case buf::Isa::AVX2: return reduceAVX2<Acc, T, Op>;
+	case buf::Isa::AVX512: return reduceAVX512<Acc, T, Op>;
+#endif
+	default: return reduceScalar<Acc, T, Op>;
+	}
+}
+
+// One per Acc/T/Op combination, chosen the first time it is used
+template <typename Acc, typename T, typename Op>
+Kernel<Acc, T, Op> bestKernel()
+{
+	static const Kernel<Acc, T, Op> k = kernelFor<Acc, T, Op>(buf::bestIsa());
+	return k;
+}
+
+// Splits [0, n) into chunks for the pool, reduces each with f(begin, end) into its own slot and combines the slots in chunk order,
+// so the result doesn't depend on which thread got which chunk
+template <typename Acc, typename Op, typename F>
+Acc parallelChunks(size_t n, Op op, F f, const par::Config &cfg, size_t elemSize)
+{
+	ThreadPool &pool = cfg.pool ? *cfg.pool : ThreadPool::global();
+	unsigned threads = cfg.threads ? cfg.threads : pool.workers() + 1;
+	size_t chunk = std::max(n / (threads * 4) + 1, par::minChunkBytes / elemSize);
+	std::vector<Acc> partial((n + chunk - 1) / chunk, Op::template identity<Acc>());
+	pool.parallelFor(n, chunk, [&](size_t begin, size_t end) { partial[begin / chunk] = f(begin, end); }, threads);
+	Acc r = Op::template identity<Acc>();
+	for (auto x : partial)
+		r = op(r, x);
+	return r;
+}
+
+} // namespace detail
+
+template <typename Acc, typename T, typename Op>
+Acc reduce(Sequenced, const T *p, size_t n, Op op, Acc init = Op::template identity<Acc>())
+{
+	return op(init, detail::bestKernel<Acc, T, Op>()(p, n, op));
+}
+
+template <typename Acc, typename T, typename Op>
+Acc reduce(const Parallel &policy, const T *p, size_t n, Op op, Acc init = Op::template identity<Acc>())
+{
+	auto kernel = detail::bestKernel<Acc, T, Op>();
+	return op(init, detail::parallelChunks<Acc>(n, op, [&](size_t begin, size_t end) { return kernel(p + begin, end - begin, op); }, policy.cfg, sizeof(T)));
+}
+
+template <typename Acc, typename T, typename Op>
+Acc reduce(const T *p, size_t n, Op op, Acc init = Op::template identity<Acc>()) { return reduce<Acc>(seq, p, n, op, init); }
+
+// Acc defaults to the element type
+template <typename T, typename Op>
+T reduce(const T *p, size_t n, Op op) { return reduce<T>(seq, p, n, op); }
+
+// Kahan (compensated) summation: every lane carries the rounding error of its adds along and feeds it back in, so the error stays
+// around one rounding no matter how long the range is. Needs strict float semantics, -ffast-math optimizes the compensation away.
+template <typename F>
+F sumKahan(const F *p, size_t n)
+{
+	constexpr size_t L = detail::lanes<F>;
+	F sum[L] = {}, comp[L] = {};
+	auto add = [&](size_t j, F x) {
+		F y = x - comp[j];
+		F t = sum[j] + y;
+		comp[j] = (t - sum[j]) - y;
+		sum[j] = t;
+	};
+	size_t i = 0;
+	for (; i + L <= n; i += L)
+		for (size_t j = 0; j < L; j++)
+			add(j, p[i + j]);
+	for (size_t j = 0; i < n; i++, j++)
+		add(j, p[i]);
+	for (size_t j = 1; j < L; j++) { // the lanes, compensated as well
+		add(0, sum[j]);
+		add(0, -comp[j]);
+	}
+	return sum[0];
+}
+
+// Pairwise summation: sum the two halves separately and add them, so the error grows with log(n) instead of n. The leaves are big
+// enough to use the lane kernel, which makes it about as fast as the plain reduction
+template <typename F>
+F sumPairwise(const F *p, size_t n)
+{
+	constexpr size_t leaf = 16 * detail::lanes<F>;
+	if (n <= leaf)
+		return detail::bestKernel<F, F, Plus>()(p, n, Plus {});
+	size_t half = n / 2;
+	return sumPairwise(p, half) + sumPairwise(p + half, n - half);
+}
+
+template <typename F>
+F sumKahan(const Parallel &policy, const F *p, size_t n)
+{
+	return detail::parallelChunks<F>(n, Plus {}, [&](size_t begin, size_t end) { return sumKahan(p + begin, end - begin); }, policy.cfg, sizeof(F));
+}
+
+} // namespace fold
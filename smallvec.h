@@ -0,0 +1,266 @@
+#pragma once
+
+// Batch insertion and a vector with inline storage, for push_back_vec in main() (one push_back per argument: copies every argument, and
+// the vector may reallocate several times on the way).
+//
+//	emplace_many(v, a, std::move(b), "c");			// reserves once, then constructs each element in place from its forwarded argument
+//	emplace_range(v, other.begin(), other.end());	// same for a range, one reserve for the whole range when its size is known up front
+//	SmallVector<int, 8> sv;							// the first 8 elements live inside the object, no heap allocation at all
+//
+// emplace_many/emplace_range work on anything with data/size/capacity/reserve/emplace_back (std::vector, SmallVector). Arguments that are v's
+// own elements are fine, like with push_back.
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Room for extra more elements. Grows at least geometrically, so lots of small batches don't each reallocate to the exact size (that would be quadratic)
+template <typename Vec>
+void reserveMore(Vec &v, size_t extra)
+{
+	if (v.size() + extra > v.capacity())
+		v.reserve(std::max(v.size() + extra, 2 * v.capacity()));
+}
+
+// Whether p points into one of v's elements, memory a reallocation frees
+template <typename Vec>
+bool pointsInto(const Vec &v, const void *p)
+{
+	std::less<const void *> before;
+	return !before(p, v.data()) && before(p, v.data() + v.size());
+}
+
+// One element per argument
+template <typename Vec, typename... Args>
+void emplace_many(Vec &v, Args &&... args)
+{
+	using T = typename Vec::value_type;
+	if constexpr (sizeof...(Args) > 0) {
+		if (v.size() + sizeof...(Args) > v.capacity() && (pointsInto(v, std::addressof(args)) || ...)) {
+			// An argument is (part of) one of v's own elements, emplace_many(v, v[0]): the new elements are made first, the reserve would free it
+			T made[] = { T(std::forward<Args>(args))... };
+			reserveMore(v, sizeof...(Args));
+			for (auto &x : made)
+				v.emplace_back(std::move(x));
+			return;
+		}
+	}
+	reserveMore(v, sizeof...(args));
+	(v.emplace_back(std::forward<Args>(args)), ...);
+}
+
+// One element per value in [first, last). Input iterators (single pass, unknown length) just get appended one by one.
+// A separate name, not an emplace_many overload: two arguments of the same type would be taken for a range (two pointers, two string literals)
+template <typename Vec, typename It>
+void emplace_range(Vec &v, It first, It last)
+{
+	using Traits = std::iterator_traits<It>;
+	if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename Traits::iterator_category>) {
+		size_t n = static_cast<size_t>(std::distance(first, last));
+		if constexpr (std::is_lvalue_reference_v<typename Traits::reference>) {
+			if (n > 0 && v.size() + n > v.capacity() && pointsInto(v, std::addressof(*first))) {
+				// v's own elements (emplace_range(v, v.begin(), v.end())): copied out first like std::vector::insert does, the reserve frees them
+				Vec copy;
+				copy.reserve(n);
+				for (; first != last; ++first)
+					copy.emplace_back(*first);
+				reserveMore(v, n);
+				for (auto &x : copy)
+					v.emplace_back(std::move(x));
+				return;
+			}
+		}
+		reserveMore(v, n);
+	}
+	for (; first != last; ++first)
+		v.emplace_back(*first);
+}
+
+template <typename T, size_t N>
+class SmallVector {
+	static_assert(N > 0, "use std::vector for no inline elements");
+
+public:
+	using value_type = T;
+	using iterator = T *;
+	using const_iterator = const T *;
+
+	SmallVector() = default;
+
+	SmallVector(std::initializer_list<T> init)
+	{
+		reserve(init.size());
+		for (auto &x : init)
+			emplace_back(x);
+	}
+
+	SmallVector(const SmallVector &other)
+	{
+		reserve(other.count);
+		std::uninitialized_copy(other.begin(), other.end(), ptr);
+		count = other.count;
+	}
+
+	SmallVector(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) { takeFrom(other); }
+
+	SmallVector &operator=(const SmallVector &other)
+	{
+		if (this != &other) {
+			clear();
+			reserve(other.count);
+			std::uninitialized_copy(other.begin(), other.end(), ptr);
+			count = other.count;
+		}
+		return *this;
+	}
+
+	SmallVector &operator=(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if (this != &other) {
+			clear();
+			release();
+			takeFrom(other);
+		}
+		return *this;
+	}
+
+	~SmallVector()
+	{
+		clear();
+		release();
+	}
+
+	template <typename... Args>
+	T &emplace_back(Args &&... args)
+	{
+		if (count < cap) {
+			::new (static_cast<void *>(ptr + count)) T(std::forward<Args>(args)...);
+		} else {
+			// The new element is constructed before the old ones move, args may refer to one of them (v.emplace_back(v[0]))
+			size_t newCap = std::max<size_t>(2 * cap, 1);
+			T *fresh = allocate(newCap);
+			try {
+				::new (static_cast<void *>(fresh + count)) T(std::forward<Args>(args)...);
+				try {
+					transferTo(fresh);
+				} catch (...) {
+					fresh[count].~T();
+					throw;
+				}
+			} catch (...) {
+				::operator delete(fresh);
+				throw;
+			}
+			adopt(fresh, newCap);
+		}
+		return ptr[count++];
+	}
+
+	void push_back(const T &value) { emplace_back(value); }
+	void push_back(T &&value) { emplace_back(std::move(value)); }
+
+	void pop_back() { ptr[--count].~T(); }
+
+	void reserve(size_t n)
+	{
+		if (n > cap) {
+			T *fresh = allocate(n);
+			try {
+				transferTo(fresh);
+			} catch (...) {
+				::operator delete(fresh);
+				throw;
+			}
+			adopt(fresh, n);
+		}
+	}
+
+	void clear()
+	{
+		std::destroy(ptr, ptr + count);
+		count = 0;
+	}
+
+	size_t size() const { return count; }
+	size_t capacity() const { return cap; }
+	bool empty() const { return count == 0; }
+	bool isInline() const { return ptr == inlineData(); }	// still in the inline buffer, never touched the heap
+
+	T *data() { return ptr; }
+	const T *data() const { return ptr; }
+	T *begin() { return ptr; }
+	T *end() { return ptr + count; }
+	const T *begin() const { return ptr; }
+	const T *end() const { return ptr + count; }
+	T &operator[](size_t i) { return ptr[i]; }
+	const T &operator[](size_t i) const { return ptr[i]; }
+	T &at(size_t i)
+	{
+		if (i >= count)
+			throw std::out_of_range("SmallVector::at");
+		return ptr[i];
+	}
+	T &front() { return ptr[0]; }
+	T &back() { return ptr[count - 1]; }
+
+private:
+	T *inlineData() { return reinterpret_cast<T *>(storage); }
+	const T *inlineData() const { return reinterpret_cast<const T *>(storage); }
+
+	static T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T))); } // T with extended alignment isn't supported
+
+	// Moves the elements into fresh, or copies them when T's move can throw (and T can be copied), like std::vector's move_if_noexcept:
+	// if this throws, what was built in fresh is destroyed again and the old elements are untouched, so the vector is as it was
+	void transferTo(T *fresh)
+	{
+		if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+			std::uninitialized_move(ptr, ptr + count, fresh);
+		else
+			std::uninitialized_copy(ptr, ptr + count, fresh);
+	}
+
+	// The elements are in fresh (capacity newCap) now, let go of the old ones and their buffer
+	void adopt(T *fresh, size_t newCap)
+	{
+		std::destroy(ptr, ptr + count);
+		release();
+		ptr = fresh;
+		cap = newCap;
+	}
+
+	void release()
+	{
+		if (!isInline())
+			::operator delete(ptr);
+		ptr = inlineData();
+		cap = N;
+	}
+
+	// Heap buffers are just taken over, inline elements have to be moved one by one
+	void takeFrom(SmallVector &other)
+	{
+		if (other.isInline()) {
+			std::uninitialized_move(other.begin(), other.end(), ptr);
+			count = other.count;
+			other.clear();
+		} else {
+			ptr = other.ptr;
+			cap = other.cap;
+			count = other.count;
+			other.ptr = other.inlineData();
+			other.cap = N;
+			other.count = 0;
+		}
+	}
+
+	alignas(T) unsigned char storage[N * sizeof(T)];
+	T *ptr = inlineData();
+	size_t count = 0, cap = N;
+};
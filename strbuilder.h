@@ -0,0 +1,176 @@
+#pragma once
+
+// String building without the copies of  s = s + 'A'  (fut3 in main(), and threadFunc): that allocates a new string, copies everything built so
+// far into it and frees the old one, every time, so n appends cost n allocations and O(n^2) bytes copied.
+//
+//	StringBuilder sb(200);			// reserves up front: one allocation, appends go in place
+//	for (...) sb += 'A';
+//	return std::move(sb).str();		// the string is moved out, not copied
+//
+// Arena is a bump-pointer allocator: it takes memory in big blocks and hands out pieces by moving a pointer, frees nothing until reset() or
+// its destruction. ArenaStringBuilder/ArenaString draw from one, so once the arena has its block a build does no heap allocation at all.
+// The arena has to outlive every string allocated from it, and one arena is for one thread at a time.
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+class Arena {
+public:
+	explicit Arena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	void *allocate(size_t n, size_t align = alignof(std::max_align_t))
+	{
+		if (!blocks.empty()) {
+			size_t at = alignedOffset(align);
+			if (at + n <= blocks[current].size) {
+				offset = at + n;
+				return blocks[current].mem.get() + at;
+			}
+		}
+		nextBlock(n + align);
+		size_t at = alignedOffset(align);
+		offset = at + n;
+		return blocks[current].mem.get() + at;
+	}
+
+	// Everything allocated so far is gone, the blocks are kept for reuse
+	void reset()
+	{
+		current = 0;
+		offset = 0;
+	}
+
+	size_t capacity() const
+	{
+		size_t n = 0;
+		for (auto &b : blocks)
+			n += b.size;
+		return n;
+	}
+
+private:
+	struct Block {
+		std::unique_ptr<char[]> mem;
+		size_t size;
+	};
+
+	// First offset at or after the current one where the address (not just the offset) is a multiple of align: the blocks are new char[],
+	// only aligned to alignof(max_align_t)
+	size_t alignedOffset(size_t align) const
+	{
+		uintptr_t base = reinterpret_cast<uintptr_t>(blocks[current].mem.get());
+		return ((base + offset + align - 1) & ~(uintptr_t(align) - 1)) - base;
+	}
+
+	// Move on to the next block that has room for n bytes, allocating one if none of the kept blocks is big enough
+	void nextBlock(size_t n)
+	{
+		size_t next = blocks.empty() ? 0 : current + 1;
+		while (next < blocks.size() && blocks[next].size < n)
+			next++;
+		if (next >= blocks.size()) {
+			size_t size = std::max(blockSize, n);
+			blocks.push_back({ std::make_unique<char[]>(size), size });
+			next = blocks.size() - 1;
+		}
+		current = next;
+		offset = 0;
+	}
+
+	size_t blockSize;
+	std::vector<Block> blocks;
+	size_t current = 0, offset = 0;
+};
+
+// std allocator interface on top of an Arena. deallocate does nothing, the arena frees everything at once
+template <typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator(Arena &arena) : arena(&arena) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+	T *allocate(size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T *, size_t) {}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+
+private:
+	template <typename U> friend class ArenaAllocator;
+	Arena *arena;
+};
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+// Appends in place into a string that reserved its capacity up front (it still grows if the hint was too small, but then geometrically)
+template <typename Str>
+class BasicStringBuilder {
+public:
+	using allocator_type = typename Str::allocator_type;
+
+	explicit BasicStringBuilder(size_t capacityHint = 0, const allocator_type &alloc = allocator_type()) : s(alloc) { s.reserve(capacityHint); }
+
+	BasicStringBuilder &operator+=(char c)
+	{
+		s.push_back(c);
+		return *this;
+	}
+
+	BasicStringBuilder &operator+=(std::string_view v)
+	{
+		s.append(v.data(), v.size());
+		return *this;
+	}
+
+	// Any mix of chars, strings and integers: sb.append("x = ", 42, '\n'). Integers are formatted with to_chars, straight into the string
+	template <typename... Args>
+	BasicStringBuilder &append(const Args &... args)
+	{
+		(appendOne(args), ...);
+		return *this;
+	}
+
+	size_t size() const { return s.size(); }
+	size_t capacity() const { return s.capacity(); }
+	const Str &view() const & { return s; }
+
+	// Hands the string over without a copy, the builder is empty afterwards
+	Str str() && { return std::move(s); }
+
+private:
+	template <typename T>
+	void appendOne(const T &v)
+	{
+		if constexpr (std::is_same_v<T, char>) {
+			s.push_back(v);
+		} else if constexpr (std::is_integral_v<T>) {
+			char tmp[24];
+			auto end = std::to_chars(tmp, tmp + sizeof(tmp), v).ptr;
+			s.append(tmp, end - tmp);
+		} else {
+			*this += std::string_view(v);
+		}
+	}
+
+	Str s;
+};
+
+using StringBuilder = BasicStringBuilder<std::string>;
+using ArenaStringBuilder = BasicStringBuilder<ArenaString>;
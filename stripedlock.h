@@ -0,0 +1,209 @@
+#pragma once
+
+// Lock striping, for when everybody takes the one  mutex m  of threadFunc although they mostly touch different data: N locks, each on its
+// own cache line, and a key picks the lock (by hash). Threads working on different keys then (mostly) don't wait for each other.
+//
+//	StripedLocks<> locks(16);										// 16 std::mutex
+//	locks.with(key, [&]() { table[key] += x; });					// lock_guard on the key's stripe around the lambda
+//	std::scoped_lock lock(locks.lockFor(key));						// same thing by hand
+//	StripedLocks<CountedLock<AdaptiveMutex>> counted(16);			// ... with contention counters: counted.stats().meanWaitNs()
+//
+// Lock types, any of them works in StripedLocks, lock_guard, scoped_lock:
+//	SpinLock				test-and-test-and-set, for very short critical sections. Yields after a while, in case the holder isn't running
+//	AdaptiveMutex			spins a bit first (learns how long from how long it took before, like glibc's PTHREAD_MUTEX_ADAPTIVE_NP), then parks
+//							on a std::mutex. Doesn't spin at all on a single core machine, the holder can't run while we spin
+//	CountedLock<L>			L plus counters: acquisitions, how many had to wait and for how long
+//
+// A key maps to one stripe, so anything that needs two keys at once has to take both stripes, lower index first (or lockAll()).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "timerwheel.h"	// cpuRelax
+
+class SpinLock {
+public:
+	void lock()
+	{
+		int spins = 0;
+		while (locked.exchange(true, std::memory_order_acquire)) {
+			while (locked.load(std::memory_order_relaxed)) { // wait on the cached value, the exchange would bounce the line between cores
+				if (++spins < 64)
+					cpuRelax();
+				else
+					std::this_thread::yield();
+			}
+		}
+	}
+
+	bool try_lock() { return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire); }
+	void unlock() { locked.store(false, std::memory_order_release); }
+
+private:
+	std::atomic<bool> locked { false };
+};
+
+class AdaptiveMutex {
+public:
+	void lock()
+	{
+		if (m.try_lock())
+			return;
+		static const bool multiCore = std::thread::hardware_concurrency() > 1;
+		if (multiCore) {
+			int limit = std::min(spinEstimate.load(std::memory_order_relaxed) * 2 + 10, maxSpins);
+			for (int spins = 1; spins <= limit; spins++) {
+				cpuRelax();
+				if (m.try_lock()) {
+					learn(spins);
+					return;
+				}
+			}
+			m.lock();
+			learn(limit); // spinning didn't pay off, the estimate goes up towards the limit (and the next limit with it, up to maxSpins)
+			return;
+		}
+		m.lock();
+	}
+
+	bool try_lock() { return m.try_lock(); }
+	void unlock() { m.unlock(); }
+
+private:
+	static constexpr int maxSpins = 100;
+
+	// Moving average of how many spins it took, only written while holding the lock
+	void learn(int spins)
+	{
+		int estimate = spinEstimate.load(std::memory_order_relaxed);
+		spinEstimate.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+	}
+
+	std::mutex m;
+	std::atomic<int> spinEstimate { 0 };
+};
+
+struct LockStats {
+	uint64_t acquisitions = 0, contended = 0;	// contended = the lock was taken, had to wait
+	double waitNs = 0;							// total time spent waiting
+
+	double contendedShare() const { return acquisitions ? double(contended) / acquisitions : 0; }
+	double meanWaitNs() const { return contended ? waitNs / contended : 0; }	// per contended acquisition
+
+	LockStats &operator+=(const LockStats &other)
+	{
+		acquisitions += other.acquisitions;
+		contended += other.contended;
+		waitNs += other.waitNs;
+		return *this;
+	}
+};
+
+// The counters are only written by whoever holds the lock, so they are plain integers: read them once the threads are done (after join()).
+// Uncontended acquisitions cost no clock reads, only a lock that was taken gets timed
+template <typename Lock>
+class CountedLock {
+public:
+	void lock()
+	{
+		if (!l.try_lock()) {
+			auto start = std::chrono::steady_clock::now();
+			l.lock();
+			counts.waitNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			counts.contended++;
+		}
+		counts.acquisitions++;
+	}
+
+	bool try_lock()
+	{
+		if (!l.try_lock())
+			return false;
+		counts.acquisitions++;
+		return true;
+	}
+
+	void unlock() { l.unlock(); }
+
+	LockStats stats() const { return counts; }
+	void resetStats() { counts = {}; }
+
+private:
+	Lock l;
+	LockStats counts;
+};
+
+template <typename Lock = std::mutex>
+class StripedLocks {
+public:
+	// Rounded up to a power of 2
+	explicit StripedLocks(size_t stripes = 16)
+	{
+		while (n < stripes)
+			n *= 2;
+		slots = std::make_unique<Slot[]>(n);
+	}
+
+	size_t stripes() const { return n; }
+
+	// Fibonacci hashing on top of std::hash: std::hash<int> is the identity, and keys that are multiples of the stripe count would all land on one stripe
+	template <typename Key>
+	size_t stripeOf(const Key &key) const
+	{
+		uint64_t h = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ull;
+		return static_cast<size_t>(h >> 40) & (n - 1);
+	}
+
+	template <typename Key>
+	Lock &lockFor(const Key &key) { return slots[stripeOf(key)].lock; }
+	Lock &stripe(size_t i) { return slots[i].lock; }
+
+	// f() with the key's stripe locked, returns what f returns
+	template <typename Key, typename F>
+	decltype(auto) with(const Key &key, F &&f)
+	{
+		std::lock_guard<Lock> guard(lockFor(key));
+		return f();
+	}
+
+	// Every stripe, in index order, the order everyone has to use when taking more than one
+	void lockAll()
+	{
+		for (size_t i = 0; i < n; i++)
+			slots[i].lock.lock();
+	}
+	void unlockAll()
+	{
+		for (size_t i = n; i-- > 0;)
+			slots[i].lock.unlock();
+	}
+
+	// Only for CountedLock stripes: the counters of all stripes added up
+	LockStats stats() const
+	{
+		LockStats total;
+		for (size_t i = 0; i < n; i++)
+			total += slots[i].lock.stats();
+		return total;
+	}
+	void resetStats()
+	{
+		for (size_t i = 0; i < n; i++)
+			slots[i].lock.resetStats();
+	}
+
+private:
+	struct alignas(64) Slot {	// one lock per cache line, or neighbouring stripes false-share and contend anyway
+		Lock lock;
+	};
+
+	size_t n = 1;
+	std::unique_ptr<Slot[]> slots;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+// Persistent thread pool, so parallel work doesn't pay for creating threads every time (which is what thread/async in main() do).
+// Only needs <thread>, no TBB and no parallel STL (<execution> is still commented out in constexpr.cpp since this g++/libstdc++ can't use it without TBB).
+//
+//	ThreadPool::global().parallelFor(n, chunk, [&](size_t begin, size_t end) { ... });
+//
+// The calling thread works on chunks too, so a pool with 0 workers (single core machine) just runs everything on the caller.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "funcref.h"
+
+class ThreadPool {
+public:
+	// Default is one worker less than the number of cores, since the thread calling parallelFor works as well
+	explicit ThreadPool(unsigned workers = defaultWorkers())
+	{
+		for (unsigned i = 0; i < workers; i++)
+			threads.emplace_back([this]() { workerLoop(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m);
+			stopping = true;
+		}
+		cv.notify_all();
+		for (auto &t : threads)
+			t.join();
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	static unsigned defaultWorkers() { return std::max(1u, std::thread::hardware_concurrency()) - 1; }
+
+	// Shared pool for everything that doesn't want its own
+	static ThreadPool &global()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	unsigned workers() const { return static_cast<unsigned>(threads.size()); }
+
+	// Fire and forget
+	void post(std::function<void()> job)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m);
+			jobs.push_back(std::move(job));
+		}
+		cv.notify_one();
+	}
+
+	// Calls fn(begin, end) for [0, n) split in chunks of chunkSize, on at most maxThreads threads (0 = caller + all workers), and returns
+	// when every chunk is done. The first exception thrown by fn is rethrown here.
+	// Waiting is on "all chunks done", not "all helpers done", so helpers that get to run late just find nothing left, which also makes
+	// it safe to call parallelFor from inside a pool job (the caller can always finish all chunks by itself).
+	// fn is only referenced (function_ref, no copy, no allocation): it's never called after parallelFor returns, see ForState::work
+	void parallelFor(size_t n, size_t chunkSize, function_ref<void (size_t, size_t)> fn, unsigned maxThreads = 0)
+	{
+		if (n == 0)
+			return;
+		chunkSize = std::max<size_t>(chunkSize, 1);
+		size_t chunks = (n + chunkSize - 1) / chunkSize;
+		unsigned helpers = maxThreads == 0 ? workers() : std::min(workers(), maxThreads - 1);
+		helpers = static_cast<unsigned>(std::min<size_t>(helpers, chunks - 1));
+		if (helpers == 0) {
+			fn(0, n);
+			return;
+		}
+
+		auto state = std::make_shared<ForState>();
+		state->fn = fn;
+		state->n = n;
+		state->chunkSize = chunkSize;
+		state->chunks = chunks;
+		for (unsigned i = 0; i < helpers; i++)
+			post([state]() { state->work(); });
+		state->work();
+
+		std::unique_lock<std::mutex> lock(state->m);
+		state->cv.wait(lock, [&]() { return state->done.load() == state->chunks; });
+		if (state->error)
+			std::rethrow_exception(state->error);
+	}
+
+private:
+	struct ForState {
+		function_ref<void (size_t, size_t)> fn;	// helpers that come late take no chunk, so they never call it
+		size_t n = 0, chunkSize = 0, chunks = 0;
+		std::atomic<size_t> next { 0 }, done { 0 };
+		std::mutex m;
+		std::condition_variable cv;
+		std::exception_ptr error;
+
+		void work()
+		{
+			for (size_t c; (c = next++) < chunks;) {
+				try {
+					fn(c * chunkSize, std::min(n, (c + 1) * chunkSize));
+				} catch (...) {
+					std::scoped_lock<std::mutex> lock(m);
+					if (!error)
+						error = std::current_exception();
+				}
+				if (++done == chunks) {
+					std::scoped_lock<std::mutex> lock(m); // so the notify can't slip in between the caller's check and its wait
+					cv.notify_all();
+				}
+			}
+		}
+	};
+
+	void workerLoop()
+	{
+		for (;;) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m);
+				cv.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (jobs.empty())
+					return; // stopping and nothing left to do
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::deque<std::function<void()>> jobs;
+	std::mutex m;
+	std::condition_variable cv;
+	bool stopping = false;
+};
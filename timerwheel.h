@@ -0,0 +1,271 @@
+#pragma once
+
+// Hierarchical timer wheel driven by one timer thread, for sub-millisecond deadlines and periodic work without one sleep syscall per tick per thread
+// (threadFunc does Sleep(1) 200 times in each thread, and Sleep() is a nanosleep with millisecond granularity that usually oversleeps).
+//
+//	TimerWheel wheel;
+//	wheel.scheduleAfter(250us, [] { ... });						// one shot
+//	wheel.schedulePeriodic(1ms, [&] { ...; return --left > 0; });	// periodic, return false to stop
+//
+// 4 levels of 64 slots (like the classic Linux kernel timer wheel): level 0 holds the next 64 ticks, level 1 the next 64*64 and so on, timers are
+// moved ("cascaded") down a level when their turn comes. Insert is O(1), firing is O(1) per timer.
+// The thread waits with a hybrid: sleep on a condition variable until shortly before the deadline, then spin the last bit (TimerWheelConfig::spin),
+// since waking from a sleep typically takes 50+ us. spin = 0 means sleep only (kinder to other threads on a busy or single core machine).
+// Callbacks run on the timer thread, one after the other, so they should be short (hand longer work to a thread pool).
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>	// _mm_pause
+#endif
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	_mm_pause(); // tells the cpu we're spinning (saves power, frees resources for the hyper-thread sibling)
+#else
+	std::this_thread::yield();
+#endif
+}
+
+// Sleep until shortly before deadline, then spin for the rest, for wake-ups that are much more precise than a plain sleep
+inline void hybridSleepUntil(std::chrono::steady_clock::time_point deadline, std::chrono::steady_clock::duration spin = std::chrono::microseconds(50))
+{
+	auto now = std::chrono::steady_clock::now();
+	if (deadline - spin > now)
+		std::this_thread::sleep_until(deadline - spin);
+	while (std::chrono::steady_clock::now() < deadline)
+		cpuRelax();
+}
+
+// How late callbacks/wake-ups were compared to their deadline, in MICRO seconds
+class JitterStats {
+public:
+	void add(double lateUs)
+	{
+		if (samples.size() < maxSamples)
+			samples.push_back(lateUs);
+	}
+	void clear() { samples.clear(); }
+	size_t count() const { return samples.size(); }
+	double percentile(double p) const
+	{
+		if (samples.empty())
+			return 0;
+		auto sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()))];
+	}
+	double mean() const
+	{
+		double sum = 0;
+		for (auto s : samples)
+			sum += s;
+		return samples.empty() ? 0 : sum / samples.size();
+	}
+	double max() const { return samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end()); }
+
+private:
+	static constexpr size_t maxSamples = 1 << 20;
+	std::vector<double> samples;
+};
+
+struct TimerWheelConfig {
+	std::chrono::steady_clock::duration tick = std::chrono::microseconds(50);	// resolution
+	std::chrono::steady_clock::duration spin = std::chrono::microseconds(50);	// spin this long before each deadline instead of sleeping
+};
+
+class TimerWheel {
+public:
+	using clock = std::chrono::steady_clock;
+
+	explicit TimerWheel(TimerWheelConfig cfg = {}) : cfg(cfg), start(clock::now())
+	{
+		worker = std::thread([this]() { run(); });
+	}
+
+	~TimerWheel()
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m);
+			stopping = true;
+		}
+		cv.notify_all();
+		worker.join(); // timers that haven't fired yet are dropped
+	}
+
+	TimerWheel(const TimerWheel &) = delete;
+	TimerWheel &operator=(const TimerWheel &) = delete;
+
+	void scheduleAt(clock::time_point deadline, std::function<void()> fn)
+	{
+		add({ deadline, clock::duration::zero(), [fn = std::move(fn)]() { fn(); return false; } });
+	}
+
+	void scheduleAfter(clock::duration delay, std::function<void()> fn) { scheduleAt(clock::now() + delay, std::move(fn)); }
+
+	// fn is called every period (first time one period from now) for as long as it returns true.
+	// Deadlines are start + k * period, so a late callback doesn't push the following ones back (no drift).
+	void schedulePeriodic(clock::duration period, std::function<bool()> fn) { add({ clock::now() + period, period, std::move(fn) }); }
+
+	size_t pending() const
+	{
+		std::scoped_lock<std::mutex> lock(m);
+		return count;
+	}
+
+	JitterStats jitter() const
+	{
+		std::scoped_lock<std::mutex> lock(m);
+		return stats;
+	}
+
+	void resetJitter()
+	{
+		std::scoped_lock<std::mutex> lock(m);
+		stats.clear();
+	}
+
+private:
+	static constexpr int levelBits = 6;
+	static constexpr uint64_t slots = 1 << levelBits, slotMask = slots - 1;
+	static constexpr int levels = 4;
+
+	struct Timer {
+		clock::time_point deadline;
+		clock::duration period;	// zero for one shot
+		std::function<bool()> fn;
+		uint64_t expiry = 0;	// tick it fires at
+	};
+
+	void add(Timer t)
+	{
+		{
+			std::scoped_lock<std::mutex> lock(m);
+			if (count == 0)
+				current = tickOf(clock::now()); // wheel is empty, skip the idle ticks instead of walking through them later
+			t.expiry = tickOf(t.deadline);
+			insert(std::move(t));
+			count++;
+			wake = true;	// might be earlier than what the timer thread is waiting for
+		}
+		cv.notify_one();
+	}
+
+	// First tick at or after tp, so timers never fire early
+	uint64_t tickOf(clock::time_point tp) const
+	{
+		if (tp <= start)
+			return 0;
+		return static_cast<uint64_t>((tp - start + cfg.tick - clock::duration(1)) / cfg.tick);
+	}
+
+	void insert(Timer t)
+	{
+		uint64_t e = std::max(t.expiry, current);
+		uint64_t delta = e - current;
+		int level = 0;
+		while (level < levels - 1 && delta >= (uint64_t(1) << (levelBits * (level + 1))))
+			level++;
+		if (level == levels - 1 && delta >= (uint64_t(1) << (levelBits * levels)))
+			e = current + (uint64_t(1) << (levelBits * levels)) - 1; // beyond the wheel, park it in the farthest slot, it is re-checked on cascade
+		wheel[level][(e >> (levelBits * level)) & slotMask].push_back(std::move(t));
+	}
+
+	// Move the timers of one slot down the levels (they are now close enough for a finer level)
+	void cascade(int level, uint64_t index)
+	{
+		auto moving = std::move(wheel[level][index]);
+		wheel[level][index].clear();
+		for (auto &t : moving)
+			insert(std::move(t));
+	}
+
+	// Processes tick 'current': cascade when a level wraps around, then collect the level 0 slot
+	void processTick(std::vector<Timer> &due)
+	{
+		for (int level = 1; level < levels; level++) {
+			if ((current >> (levelBits * (level - 1))) & slotMask)
+				break;
+			cascade(level, (current >> (levelBits * level)) & slotMask);
+		}
+		auto &slot = wheel[0][current & slotMask];
+		for (auto &t : slot)
+			due.push_back(std::move(t));
+		slot.clear();
+		current++;
+	}
+
+	// Next tick that has something to do: a non-empty level 0 slot or a cascade point (at most 64 ticks away)
+	uint64_t nextTick() const
+	{
+		uint64_t t = current;
+		while (wheel[0][t & slotMask].empty() && (t & slotMask) != 0)
+			t++;
+		return t;
+	}
+
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(m);
+		std::vector<Timer> due;
+		while (!stopping) {
+			if (count == 0) {
+				cv.wait(lock, [this]() { return stopping || count > 0; });
+				continue;
+			}
+			auto deadline = start + static_cast<int64_t>(nextTick()) * cfg.tick;
+			wake = false;
+			if (cv.wait_until(lock, deadline - cfg.spin, [this]() { return stopping || wake; }))
+				continue; // stopping, or a new timer that may be due earlier: recompute
+			lock.unlock();
+			while (clock::now() < deadline)
+				cpuRelax();
+			lock.lock();
+
+			uint64_t nowTick = tickOf(clock::now());
+			while (current <= nowTick)
+				processTick(due);
+			count -= due.size();
+
+			lock.unlock();
+			std::vector<Timer> again;
+			std::vector<double> late;
+			for (auto &t : due) {
+				late.push_back(std::chrono::duration<double, std::micro>(clock::now() - t.deadline).count());
+				if (t.fn() && t.period != clock::duration::zero()) {
+					t.deadline += t.period;
+					again.push_back(std::move(t));
+				}
+			}
+			due.clear();
+			lock.lock();
+			for (auto l : late)
+				stats.add(l);
+			for (auto &t : again) {
+				t.expiry = tickOf(t.deadline);
+				insert(std::move(t));
+				count++;
+			}
+		}
+	}
+
+	TimerWheelConfig cfg;
+	clock::time_point start;
+	std::array<std::array<std::vector<Timer>, slots>, levels> wheel;
+	uint64_t current = 0; // next tick to process
+	size_t count = 0;
+	bool stopping = false, wake = false;
+	JitterStats stats;
+	mutable std::mutex m;
+	std::condition_variable cv;
+	std::thread worker;
+};